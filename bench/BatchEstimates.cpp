@@ -0,0 +1,98 @@
+// Batch conversion estimates against one book at depths 10, 100 and 1000: one
+// virtual estimate per amount against estimate_conversions_from_1/2 on each
+// search kernel this CPU supports. Every batch result is checked against the
+// scalar estimate; any mismatch prints FAIL and exits 1.
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "LeveledOrderBook.hpp"
+
+namespace {
+const size_t amount_count = 4096;
+const size_t rounds = 200;
+
+struct BenchOrderBook : public LeveledOrderBook {
+  BenchOrderBook(const Symbol& s1, const Symbol& s2, size_t depth) : LeveledOrderBook(s1, s2, decimals, decimals, depth) {}
+  using LeveledOrderBook::apply_updates;
+};
+
+void seed(BenchOrderBook& book, size_t depth, std::mt19937_64& rng) {
+  std::vector<LevelUpdate> levels;
+  for (size_t i = 0; i < depth; i++) {
+    Amount offset = Amount::from_raw(int64_t(i) * Amount::one / 2);
+    levels.push_back({BookSide::Ask, Amount::from_integer(30001) + offset, Amount::from_raw(rng() % (2 * Amount::one) + 1)});
+    levels.push_back({BookSide::Bid, Amount::from_integer(29999) - offset, Amount::from_raw(rng() % (2 * Amount::one) + 1)});
+  }
+  book.apply_updates(levels, true);
+}
+
+template <class Run>
+double time_ns(Run&& run) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < rounds; i++)
+    run();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * amount_count);
+}
+
+// Returns the number of batch results that differ from the scalar estimates.
+size_t bench(const Symbol& s1, const Symbol& s2, size_t depth, std::mt19937_64& rng) {
+  BenchOrderBook book(s1, s2, depth);
+  seed(book, depth, rng);
+  const GenericOrderBook& generic = book;
+  size_t total_mismatches = 0;
+
+  // Amounts reach from the top level to past the whole side.
+  std::vector<Amount> volumes(amount_count), notionals(amount_count), out(amount_count), expected(amount_count);
+  for (size_t i = 0; i < amount_count; i++) {
+    volumes[i] = Amount::from_raw(rng() % (int64_t(depth) * 11 / 10 * Amount::one + 1));
+    notionals[i] = Amount::from_raw(rng() % (int64_t(depth) * 33000 * Amount::one + 1));
+  }
+
+  struct Direction {
+    const char* name;
+    const std::vector<Amount>& amounts;
+    __int128 (GenericOrderBook::*single)(__int128) const;
+    void (LeveledOrderBook::*batch)(std::span<const Amount>, std::span<Amount>) const;
+  };
+  const Direction directions[] = {
+      {"from_1", volumes, &GenericOrderBook::estimate_conversion_from_1, &LeveledOrderBook::estimate_conversions_from_1},
+      {"from_2", notionals, &GenericOrderBook::estimate_conversion_from_2, &LeveledOrderBook::estimate_conversions_from_2},
+  };
+  for (const Direction& d : directions) {
+    double scalar_ns = time_ns([&] {
+      for (size_t i = 0; i < amount_count; i++)
+        expected[i] = Amount::from_raw((generic.*d.single)(d.amounts[i].raw()));
+    });
+    std::cout << "depth=" << depth << " " << d.name << " scalar ns_per_amount=" << scalar_ns << std::endl;
+
+    for (SearchIsa isa : {SearchIsa::Scalar, SearchIsa::Avx2, SearchIsa::Avx512}) {
+      if (!use_search_isa(isa))
+        continue;
+      double batch_ns = time_ns([&] { (book.*d.batch)(d.amounts, out); });
+      size_t mismatches = 0;
+      for (size_t i = 0; i < amount_count; i++)
+        mismatches += out[i] != expected[i];
+      std::cout << "depth=" << depth << " " << d.name << " batch_" << search_isa_name(isa)
+                << " ns_per_amount=" << batch_ns << " speedup=" << scalar_ns / batch_ns
+                << " mismatches=" << mismatches << std::endl;
+      total_mismatches += mismatches;
+    }
+    use_search_isa(best_search_isa());
+  }
+  return total_mismatches;
+}
+} //namespace
+
+int main() {
+  SymbolFactory& factory = SymbolFactory::get_factory();
+  const Symbol& xbt = factory.get_symbol("XBT", "bench");
+  const Symbol& usd = factory.get_symbol("USD", "bench");
+  std::mt19937_64 rng(5);
+  size_t mismatches = 0;
+  for (size_t depth : {10, 100, 1000})
+    mismatches += bench(xbt, usd, depth, rng);
+  std::cout << (mismatches == 0 ? "PASS" : "FAIL") << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// Randomized check of FlatBookSide against MapBookSide: both get the same
+// updates, snapshots and clears, and after every few steps the flat side's
+// prices, cumulatives and level searches, single and batch, must match what the
+// map's levels give. Covers both orders and depths around the batch search
+// limit and up to 1000, where compaction and the worst end falling off happen
+// all the time. Also asks for levels past the end, as a torn seqlock read may.
+//
+//   booker_book_side_check [steps]   prints the first mismatch per depth, exits 1 on any
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BookLevels.hpp"
+
+namespace {
+volatile int64_t past_end_price;
+
+struct Level {
+  Amount price;
+  Amount volume;
+};
+
+template <class Better>
+class Checker {
+  size_t depth;
+  std::mt19937_64 rng;
+  FlatBookSide<Better> flat;
+  MapBookSide<Better> map;
+  // Best first levels of the map and their running totals.
+  std::vector<Level> levels;
+  std::vector<__int128> volumes;
+  std::vector<__int128> notionals;
+  std::string failure;
+
+  void fail(const std::string& what, size_t step) {
+    if (failure.empty())
+      failure = what + " at step " + std::to_string(step);
+  }
+
+  // Prices from the top of the book down in ticks, positive worse.
+  Amount price_at(int64_t ticks) const {
+    return Amount::from_integer(Better()(Amount::from_integer(1), Amount::from_integer(2)) ? 30000 + ticks : 30000 - ticks);
+  }
+
+  void update(Amount price, Amount volume) {
+    flat.update(price, volume);
+    map.update(price, volume);
+  }
+
+  void load_reference() {
+    levels.clear();
+    map.for_each([&](Amount price, Amount volume) {
+      levels.push_back({price, volume});
+      return true;
+    });
+    volumes.assign(1, 0);
+    notionals.assign(1, 0);
+    for (const Level& level : levels) {
+      volumes.push_back(volumes.back() + level.volume.raw());
+      notionals.push_back(notionals.back() + level.volume.raw() * level.price.raw());
+    }
+  }
+
+  size_t reference_within(const std::vector<__int128>& totals, __int128 amount) const {
+    return std::upper_bound(totals.begin() + 1, totals.end(), amount) - totals.begin() - 1;
+  }
+
+  void compare(size_t step) {
+    flat.commit();
+    map.commit();
+    load_reference();
+    const size_t size = levels.size();
+    if (flat.size() != size)
+      return fail("size " + std::to_string(flat.size()) + " != " + std::to_string(size), step);
+
+    size_t level = 0;
+    flat.for_each([&](Amount price, Amount volume) {
+      if (level >= size || price != levels[level].price || volume != levels[level].volume)
+        fail("for_each level " + std::to_string(level), step);
+      level++;
+      return true;
+    });
+    if (level != size)
+      fail("for_each visited " + std::to_string(level), step);
+    for (size_t k = 0; k <= size; k++) {
+      if (k < size && flat.price(k) != levels[k].price)
+        fail("price " + std::to_string(k), step);
+      if (flat.cumulative_volume(k).raw() != volumes[k] || flat.cumulative_notional(k) != notionals[k])
+        fail("cumulative " + std::to_string(k), step);
+    }
+    // Past the end, as readers of a torn copy may ask. Prices there only need to
+    // come from within the arrays, which sanitizer builds check.
+    past_end_price = flat.price(size + 3).raw();
+    past_end_price = flat.price(2 * depth + 16).raw();
+    if (flat.cumulative_volume(size + 3).raw() != volumes[size] || flat.cumulative_notional(size + 3) != notionals[size])
+      fail("cumulative past the end", step);
+
+    // Amounts within the top level, across the book, exactly at level totals and past the end.
+    std::vector<int64_t> amounts{0, 1};
+    for (int i = 0; i < 16; i++)
+      amounts.push_back(int64_t(rng() % uint64_t(int64_t(depth) * 60 * Amount::one + 1)));
+    for (size_t k : {size_t(1), size / 2, size}) {
+      if (k > 0 && k <= size && volumes[k] < INT64_MAX) {
+        amounts.push_back(int64_t(volumes[k]));
+        amounts.push_back(int64_t(volumes[k]) - 1);
+      }
+    }
+    std::vector<uint32_t> batch(amounts.size());
+    flat.levels_within_volumes(amounts.data(), amounts.size(), batch.data());
+    for (size_t i = 0; i < amounts.size(); i++) {
+      const size_t expected = reference_within(volumes, amounts[i]);
+      if (flat.levels_within_volume(Amount::from_raw(amounts[i])) != expected
+          || std::min<size_t>(batch[i], size) != expected)
+        fail("levels_within_volume(s) " + std::to_string(amounts[i]), step);
+    }
+
+    // Notionals in whole quote units, plus exact level totals for the scalar search.
+    for (int64_t& amount : amounts)
+      amount /= 100;
+    flat.levels_within_notionals(amounts.data(), amounts.size(), batch.data());
+    for (size_t i = 0; i < amounts.size(); i++) {
+      const __int128 notional = __int128(amounts[i]) * Amount::one;
+      const size_t expected = reference_within(notionals, notional);
+      if (flat.levels_within_notional(notional) != expected || std::min<size_t>(batch[i], size) != expected)
+        fail("levels_within_notional(s) " + std::to_string(amounts[i]), step);
+    }
+    for (size_t k = 1; k <= size; k += std::max<size_t>(1, size / 7)) {
+      if (flat.levels_within_notional(notionals[k]) != k || flat.levels_within_notional(notionals[k] - 1) != k - 1)
+        fail("levels_within_notional at level total " + std::to_string(k), step);
+    }
+  }
+public:
+  Checker(size_t depth, uint64_t seed) : depth(depth), rng(seed), flat(depth), map(depth) {}
+
+  // Empty when the sides agreed throughout.
+  std::string run(size_t steps) {
+    const int64_t spread = int64_t(depth) * 3 / 2 + 8;
+    for (size_t step = 0; step < steps && failure.empty(); step++) {
+      const unsigned op = rng() % 200;
+      if (op == 0) {
+        flat.clear();
+        map.clear();
+      } else if (op < 4) {
+        // Snapshot, best first with gaps, sometimes more levels than the depth.
+        flat.clear();
+        map.clear();
+        int64_t ticks = int64_t(rng() % 4);
+        for (size_t i = 0, n = rng() % (depth + 6); i < n; i++, ticks += 1 + int64_t(rng() % 3))
+          update(price_at(ticks), Amount::from_raw(int64_t(rng() % (100 * Amount::one)) + 1));
+      } else {
+        // Mostly near the top, as on the feed, else anywhere down to past the depth.
+        const int64_t ticks = op < 120 ? int64_t(rng() % 20) : int64_t(rng() % uint64_t(spread));
+        const Amount volume = rng() % 4 == 0 ? Amount() : Amount::from_raw(int64_t(rng() % (100 * Amount::one)) + 1);
+        update(price_at(ticks), volume);
+      }
+      if (rng() % 4 == 0)
+        compare(step);
+    }
+    return failure;
+  }
+};
+
+template <class Better>
+bool check(const char* order, size_t depth, size_t steps) {
+  for (uint64_t seed = 1; seed <= 3; seed++) {
+    const std::string failure = Checker<Better>(depth, seed).run(steps);
+    if (!failure.empty()) {
+      std::printf("%s depth %zu seed %llu: %s\n", order, depth, static_cast<unsigned long long>(seed), failure.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  const size_t steps = argc > 1 ? std::stoul(argv[1]) : 20000;
+  bool passed = true;
+  for (size_t depth : {1, 2, 3, 10, 25, 63, 64, 65, 100, 500, 1000}) {
+    const bool asks = check<std::less<Amount>>("asks", depth, steps);
+    const bool bids = check<std::greater<Amount>>("bids", depth, steps);
+    std::printf("depth %4zu %s\n", depth, asks && bids ? "ok" : "FAILED");
+    passed = passed && asks && bids;
+  }
+  std::printf("%s\n", passed ? "PASS" : "FAIL");
+  return passed ? 0 : 1;
+}
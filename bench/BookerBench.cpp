@@ -0,0 +1,402 @@
+// Microbenchmarks of the hot paths, one JSON object per line on stdout so runs
+// can be diffed between releases:
+//   {"bench":"estimate_conversion/from_1/flat/25","ns_per_op":12.3,"ns_per_op_median":12.5,"ops":1000000}
+// The first line describes the machine and build. Cases run `--repeats` times
+// (default 5), ns_per_op is the fastest repetition. `--filter=<text>` runs only
+// the cases whose name contains text, `--quick` runs a tenth of the operations.
+//
+// The market is synthetic: 150 symbols and 700 pairs loaded into an offline
+// KrakenExchange from a generated AssetPairs file, books filled by replaying
+// generated snapshot frames.
+#include <Poco/Util/IniFileConfiguration.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LatencyTrace.hpp"
+#include "LevelSearch.hpp"
+#include "LeveledOrderBook.hpp"
+#include "connector/input/Kraken.hpp"
+#include "connector/input/KrakenBookParser.hpp"
+#include "strategy/TriangularCycleIndex.hpp"
+#include "Utils.hpp"
+
+Poco::AutoPtr<Poco::Util::IniFileConfiguration> config;
+
+namespace {
+const size_t market_symbols = 150;
+const size_t market_pairs = 700;
+const size_t market_depth = 25;
+
+struct Options {
+  std::string filter;
+  int repeats = 5;
+  double scale = 1.0;
+};
+Options options;
+// Results of the timed batches are stored here, so their work cannot be dropped.
+volatile uint64_t sink;
+
+struct BenchOrderBook : public LeveledOrderBook {
+  using LeveledOrderBook::LeveledOrderBook;
+  using LeveledOrderBook::apply_updates;
+  using LeveledOrderBook::updateAskLevel;
+  using LeveledOrderBook::updateBidLevel;
+};
+
+size_t scaled(size_t ops) {
+  return std::max<size_t>(1, static_cast<size_t>(ops * options.scale));
+}
+
+bool selected(const std::string& name) {
+  return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// Times batch(ops) `repeats` times and prints one result line. batch returns a
+// value derived from its work, which goes to the sink.
+template <class Batch>
+void measure(const std::string& name, size_t ops, Batch&& batch, const std::string& extra = "") {
+  if (!selected(name))
+    return;
+  std::vector<double> samples;
+  for (int r = 0; r < options.repeats; r++) {
+    auto start = std::chrono::steady_clock::now();
+    sink = batch(ops);
+    samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops);
+  }
+  std::sort(samples.begin(), samples.end());
+  std::printf("{\"bench\":\"%s\",\"ns_per_op\":%.3f,\"ns_per_op_median\":%.3f,\"ops\":%zu%s%s}\n", name.c_str(),
+              samples.front(), samples[samples.size() / 2], ops, extra.empty() ? "" : ",", extra.c_str());
+  std::fflush(stdout);
+}
+
+std::string price_text(double price) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.8f", price);
+  return text;
+}
+
+std::string level_text(double price, double volume) {
+  return "[\"" + price_text(price) + "\",\"" + price_text(volume) + "\",\"1700000000.000000\"]";
+}
+
+struct SyntheticPair {
+  std::string base, quote;
+  double mid;
+};
+
+struct SyntheticMarket {
+  std::vector<std::string> symbols;
+  std::vector<double> usd_values;
+  std::vector<SyntheticPair> pairs;
+};
+
+// Symbols get a USD value, pairs trade at the ratio of their values plus a little
+// noise so that some cycles are profitable.
+SyntheticMarket make_market(std::mt19937_64& rng) {
+  SyntheticMarket market;
+  std::uniform_real_distribution<double> value(0.5, 50.0);
+  std::normal_distribution<double> noise(0.0, 0.002);
+  for (size_t i = 0; i < market_symbols; i++) {
+    char name[8];
+    std::snprintf(name, sizeof(name), "S%03zu", i);
+    market.symbols.push_back(name);
+    market.usd_values.push_back(value(rng));
+  }
+  std::set<std::pair<size_t, size_t>> taken;
+  while (market.pairs.size() < market_pairs) {
+    size_t a = rng() % market_symbols, b = rng() % market_symbols;
+    if (a == b || taken.count({a, b}) || taken.count({b, a}))
+      continue;
+    taken.insert({a, b});
+    double mid = market.usd_values[a] / market.usd_values[b] * (1 + noise(rng));
+    market.pairs.push_back({market.symbols[a], market.symbols[b], mid});
+  }
+  return market;
+}
+
+void write_asset_pairs(const SyntheticMarket& market, const std::string& path) {
+  std::ofstream out(path);
+  out << "{\"error\":[],\"result\":{";
+  for (size_t i = 0; i < market.pairs.size(); i++) {
+    const SyntheticPair& pair = market.pairs[i];
+    out << (i ? "," : "") << "\"" << pair.base << pair.quote << "\":{\"wsname\":\"" << pair.base << "/" << pair.quote
+        << "\",\"base\":\"" << pair.base << "\",\"quote\":\"" << pair.quote
+        << "\",\"pair_decimals\":8,\"lot_decimals\":8}";
+  }
+  out << "}}";
+}
+
+std::string snapshot_frame(const SyntheticPair& pair, size_t channel, size_t depth) {
+  std::string asks, bids;
+  for (size_t i = 0; i < depth; i++) {
+    asks += std::string(i ? "," : "") + level_text(pair.mid * (1.00025 + 0.0002 * i), 1.0 + i % 3);
+    bids += std::string(i ? "," : "") + level_text(pair.mid * (0.99975 - 0.0002 * i), 1.0 + i % 3);
+  }
+  return "[" + std::to_string(channel) + ",{\"as\":[" + asks + "],\"bs\":[" + bids + "]},\"book-"
+         + std::to_string(depth) + "\",\"" + pair.base + "/" + pair.quote + "\"]";
+}
+
+std::string update_frame(const SyntheticPair& pair, size_t channel, size_t depth, std::mt19937_64& rng) {
+  bool ask = rng() & 1;
+  std::string levels;
+  for (size_t n = 1 + rng() % 3, i = 0; i < n; i++) {
+    double offset = 0.00025 + 0.0002 * (rng() % depth);
+    double volume = rng() % 5 == 0 ? 0.0 : 0.1 + (rng() % 1000) / 100.0;
+    levels += std::string(i ? "," : "") + level_text(pair.mid * (ask ? 1 + offset : 1 - offset), volume);
+  }
+  return "[" + std::to_string(channel) + ",{\"" + (ask ? "a" : "b") + "\":[" + levels + "]},\"book-"
+         + std::to_string(depth) + "\",\"" + pair.base + "/" + pair.quote + "\"]";
+}
+
+void bench_parse(const SyntheticMarket& market, std::mt19937_64& rng) {
+  std::vector<std::string> updates, snapshots;
+  for (size_t i = 0; i < 4096; i++) {
+    size_t p = rng() % market.pairs.size();
+    updates.push_back(update_frame(market.pairs[p], p, market_depth, rng));
+  }
+  for (size_t p = 0; p < 64; p++)
+    snapshots.push_back(snapshot_frame(market.pairs[p], p, market_depth));
+
+  auto run = [](const std::string& name, const std::vector<std::string>& frames, size_t ops) {
+    measure(name, ops, [&](size_t ops) {
+      KrakenBookFrame frame;
+      uint64_t levels = 0;
+      for (size_t i = 0; i < ops; i++) {
+        const std::string& text = frames[i % frames.size()];
+        if (parse_kraken_book_frame(text.data(), text.size(), frame))
+          levels += frame.levels.size();
+      }
+      return levels;
+    });
+  };
+  run("parse_frame/update", updates, scaled(2000000));
+  run("parse_frame/snapshot", snapshots, scaled(100000));
+}
+
+// What one traced stage costs: a clock read and a histogram record, nothing
+// unless built with BOOKER_LATENCY_TRACE.
+void bench_trace() {
+  measure("latency_trace/span", scaled(10000000), [](size_t ops) {
+    uint64_t start = trace_now();
+    for (size_t i = 0; i < ops; i++) {
+      const uint64_t now = trace_now();
+      trace_span(TraceSpan::Parse, start, now);
+      start = now;
+    }
+    take_latency_summaries();
+    return start;
+  });
+}
+
+void seed_book(BenchOrderBook& book, size_t depth) {
+  std::vector<LevelUpdate> levels;
+  for (size_t i = 0; i < depth; i++) {
+    levels.push_back({BookSide::Ask, Amount::from_integer(30001 + i), Amount::from_integer(1)});
+    levels.push_back({BookSide::Bid, Amount::from_integer(29999 - i), Amount::from_integer(1)});
+  }
+  book.apply_updates(levels, true);
+}
+
+const char* storage_name(BookStorage storage) {
+  return storage == BookStorage::Flat ? "flat" : "map";
+}
+
+void bench_book_updates(std::mt19937_64& rng) {
+  const Symbol& xbt = SymbolFactory::get_factory().get_symbol("XBT", "bench");
+  const Symbol& usd = SymbolFactory::get_factory().get_symbol("USD", "bench");
+  struct Update {
+    bool ask;
+    Amount price;
+    Amount volume;
+  };
+  for (BookStorage storage : {BookStorage::Flat, BookStorage::Map}) {
+    for (size_t depth : {10, 25, 100, 1000}) {
+      std::vector<Update> updates;
+      for (size_t i = 0; i < 65536; i++) {
+        bool ask = rng() & 1;
+        int64_t offset = int64_t(rng() % (depth * 2));
+        Amount volume = rng() % 5 == 0 ? Amount() : Amount::from_raw(rng() % (10 * Amount::one) + 1);
+        updates.push_back({ask, Amount::from_integer(ask ? 30001 + offset : 29999 - offset), volume});
+      }
+      BenchOrderBook book(xbt, usd, decimals, decimals, depth, storage);
+      seed_book(book, depth);
+      measure("book_update/" + std::string(storage_name(storage)) + "/" + std::to_string(depth), scaled(2000000),
+              [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) {
+          const Update& u = updates[i & (updates.size() - 1)];
+          if (u.ask)
+            book.updateAskLevel(u.price, u.volume);
+          else
+            book.updateBidLevel(u.price, u.volume);
+        }
+        return book.get_generation();
+      });
+    }
+  }
+}
+
+void bench_estimates(std::mt19937_64& rng) {
+  const Symbol& xbt = SymbolFactory::get_factory().get_symbol("XBT", "bench");
+  const Symbol& usd = SymbolFactory::get_factory().get_symbol("USD", "bench");
+  for (BookStorage storage : {BookStorage::Flat, BookStorage::Map}) {
+    for (size_t depth : {10, 25, 100, 500, 1000}) {
+      BenchOrderBook book(xbt, usd, decimals, decimals, depth, storage);
+      seed_book(book, depth);
+      // Amounts reaching anywhere into the book, from the top level to past the last.
+      std::vector<__int128> base_amounts, quote_amounts;
+      for (size_t i = 0; i < 4096; i++) {
+        base_amounts.push_back(static_cast<__int128>(rng() % ((depth + 1) * Amount::one)));
+        quote_amounts.push_back(static_cast<__int128>(rng() % ((depth + 1) * Amount::one)) * 30000);
+      }
+      const std::string suffix = "/" + std::string(storage_name(storage)) + "/" + std::to_string(depth);
+      measure("estimate_conversion/from_1" + suffix, scaled(2000000), [&](size_t ops) {
+        __int128 sum = 0;
+        for (size_t i = 0; i < ops; i++)
+          sum += book.estimate_conversion_from_1(base_amounts[i & 4095]);
+        return static_cast<uint64_t>(sum);
+      });
+      measure("estimate_conversion/from_2" + suffix, scaled(2000000), [&](size_t ops) {
+        __int128 sum = 0;
+        for (size_t i = 0; i < ops; i++)
+          sum += book.estimate_conversion_from_2(quote_amounts[i & 4095]);
+        return static_cast<uint64_t>(sum);
+      });
+    }
+  }
+}
+
+void bench_market(const SyntheticMarket& market, const std::string& directory, std::mt19937_64& rng) {
+  if (!selected("get_order_book") && !selected("get_symbol") && !selected("replay_ingest") && !selected("arbitrage_scan"))
+    return;
+  std::stringstream ini;
+  ini << "[Kraken]\nAPIKey=bench\nPrivateKey=bench\nOBDepth=" << market_depth
+      << "\nReplayPairs=" << directory << "/AssetPairs.json\n";
+  config = new Poco::Util::IniFileConfiguration(ini);
+  write_asset_pairs(market, directory + "/AssetPairs.json");
+
+  KrakenExchange kraken(true);
+  kraken.load_pairs_offline();
+
+  SymbolFactory& factory = SymbolFactory::get_factory();
+  for (size_t i = 0; i < market.symbols.size(); i++)
+    factory.get_symbol(market.symbols[i], market.symbols[i], "kraken").set_reference_rate_estimate(
+        Amount::from_string(price_text(1.0 / market.usd_values[i])));
+
+  std::vector<std::pair<const Symbol*, const Symbol*>> lookups;
+  for (size_t i = 0; i < 4096; i++) {
+    const SyntheticPair& pair = market.pairs[rng() % market.pairs.size()];
+    const Symbol* base = &factory.get_symbol(pair.base, "kraken");
+    const Symbol* quote = &factory.get_symbol(pair.quote, "kraken");
+    lookups.push_back(rng() & 1 ? std::make_pair(base, quote) : std::make_pair(quote, base));
+  }
+  measure("get_order_book", scaled(5000000), [&](size_t ops) {
+    uintptr_t sum = 0;
+    for (size_t i = 0; i < ops; i++) {
+      const auto& [s1, s2] = lookups[i & 4095];
+      sum ^= reinterpret_cast<uintptr_t>(&kraken.get_order_book(*s1, *s2));
+    }
+    return static_cast<uint64_t>(sum);
+  });
+
+  std::vector<const std::string*> names;
+  for (size_t i = 0; i < 4096; i++)
+    names.push_back(&market.symbols[rng() % market.symbols.size()]);
+  measure("get_symbol", scaled(2000000), [&](size_t ops) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < ops; i++)
+      sum += factory.get_symbol(*names[i & 4095], "kraken").get_id();
+    return sum;
+  });
+
+  // Ingest through the same path as the live feed: snapshots for every pair, then deltas.
+  const std::string capture = directory + "/capture.txt";
+  size_t capture_frames = 0;
+  {
+    std::ofstream out(capture);
+    for (size_t p = 0; p < market.pairs.size(); p++, capture_frames++)
+      out << snapshot_frame(market.pairs[p], p, market_depth) << "\n";
+    for (size_t i = 0; i < scaled(200000); i++, capture_frames++) {
+      size_t p = rng() % market.pairs.size();
+      out << update_frame(market.pairs[p], p, market_depth, rng) << "\n";
+    }
+  }
+  uint64_t replayed_levels = 0;
+  measure("replay_ingest", capture_frames, [&](size_t) {
+    KrakenExchange::ReplayStats stats = kraken.replay(capture, false);
+    replayed_levels = stats.levels;
+    return stats.book_frames;
+  });
+  if (selected("replay_ingest"))
+    std::printf("{\"bench\":\"replay_ingest/levels\",\"levels_per_frame\":%.3f}\n", double(replayed_levels) / capture_frames);
+
+  // Every book has been replayed into, scan all cycles.
+  if (!selected("arbitrage_scan"))
+    return;
+  kraken.replay(capture, false);
+  TriangularCycleIndex cycles(kraken.get_trading_graph());
+  std::vector<const GenericOrderBook*> all_books;
+  for (const SyntheticPair& pair : market.pairs)
+    all_books.push_back(&kraken.get_order_book(factory.get_symbol(pair.base, "kraken"), factory.get_symbol(pair.quote, "kraken")));
+  size_t found = 0;
+  TriangularCycleIndex::Callback count = [&](const TriangularCycleIndex::Cycle&, Amount, Amount) { found++; };
+  const std::string extra = "\"cycles\":" + std::to_string(cycles.size()) + ",\"pairs\":" + std::to_string(market.pairs.size());
+  measure("arbitrage_scan/fixed", scaled(200), [&](size_t ops) {
+    for (size_t i = 0; i < ops; i++)
+      cycles.reprice_all(Amount::from_integer(100), count);
+    return found;
+  }, extra);
+  measure("arbitrage_scan/optimal", scaled(50), [&](size_t ops) {
+    for (size_t i = 0; i < ops; i++)
+      cycles.reprice_optimal(all_books, count);
+    return found;
+  }, extra);
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--filter=", 0) == 0)
+      options.filter = arg.substr(9);
+    else if (arg.rfind("--repeats=", 0) == 0)
+      options.repeats = std::max(1, std::stoi(arg.substr(10)));
+    else if (arg == "--quick")
+      options.scale = 0.1;
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--filter=<text>] [--repeats=N] [--quick]" << std::endl;
+      return 1;
+    }
+  }
+  // Results only on stdout.
+  Poco::Logger::root().setLevel("warning");
+
+  std::printf("{\"bench\":\"_meta\",\"compiler\":\"%s\",\"cpus\":%u,\"search_isa\":\"%s\",\"latency_trace\":%s,"
+              "\"repeats\":%d,\"scale\":%.2f}\n",
+              __VERSION__, std::thread::hardware_concurrency(), search_isa_name(active_search_isa()),
+              latency_trace_enabled ? "true" : "false", options.repeats, options.scale);
+
+  const std::string directory = (std::filesystem::temp_directory_path() / "booker_bench").string();
+  std::filesystem::create_directories(directory);
+
+  std::mt19937_64 rng(2024);
+  SyntheticMarket market = make_market(rng);
+  bench_parse(market, rng);
+  bench_book_updates(rng);
+  bench_estimates(rng);
+  bench_trace();
+  bench_market(market, directory, rng);
+
+  std::filesystem::remove_all(directory);
+}
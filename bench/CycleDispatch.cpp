@@ -0,0 +1,65 @@
+// Prices one USD -> XBT -> ETH -> USD cycle per round, once through the virtual
+// GenericOrderBook interface (ReverseOrderBook legs take two indirect calls per
+// estimate) and once through BookHandle, which calls LeveledOrderBook directly.
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "strategy/CycleSizeSolver.hpp"
+
+namespace {
+const size_t rounds = 2000000;
+
+struct BenchOrderBook : public LeveledOrderBook {
+  using LeveledOrderBook::LeveledOrderBook;
+  using LeveledOrderBook::apply_updates;
+};
+
+void seed(BenchOrderBook& book, Amount ask, Amount bid, Amount step, std::mt19937_64& rng) {
+  std::vector<LevelUpdate> levels;
+  for (size_t i = 0; i < default_book_depth; i++) {
+    Amount offset = Amount::from_raw(step.raw() * i);
+    levels.push_back({BookSide::Ask, ask + offset, Amount::from_raw(rng() % (2 * Amount::one) + 1)});
+    levels.push_back({BookSide::Bid, bid - offset, Amount::from_raw(rng() % (2 * Amount::one) + 1)});
+  }
+  book.apply_updates(levels, true);
+}
+
+template <class Price>
+void run(const char* name, Price&& price) {
+  Amount sink;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < rounds; i++)
+    sink += price(Amount::from_integer(100 + i % 1000));
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << " ns_per_cycle=" << ns / rounds << " (" << sink.to_string() << ")" << std::endl;
+}
+} //namespace
+
+int main() {
+  SymbolFactory& factory = SymbolFactory::get_factory();
+  const Symbol& usd = factory.get_symbol("USD", "bench");
+  const Symbol& xbt = factory.get_symbol("XBT", "bench");
+  const Symbol& eth = factory.get_symbol("ETH", "bench");
+
+  std::mt19937_64 rng(3);
+  BenchOrderBook xbt_usd(xbt, usd), eth_xbt(eth, xbt), eth_usd(eth, usd);
+  seed(xbt_usd, Amount::from_integer(30000), Amount::from_integer(29990), Amount::from_integer(5), rng);
+  seed(eth_xbt, Amount::from_string("0.05"), Amount::from_string("0.0499"), Amount::from_string("0.0001"), rng);
+  seed(eth_usd, Amount::from_integer(1510), Amount::from_integer(1500), Amount::from_integer(2), rng);
+  ReverseOrderBook usd_xbt(xbt_usd), xbt_eth(eth_xbt);
+  const BookHandle legs[] = {{&xbt_usd, true, &usd_xbt}, {&eth_xbt, true, &xbt_eth}, {&eth_usd, false, &eth_usd}};
+
+  run("virtual", [&](Amount amount) {
+    for (const BookHandle& leg : legs) {
+      Amount fee = Amount::from_raw(leg.generic->estimate_fee_from_1(amount.raw()));
+      amount = Amount::from_raw(leg.generic->estimate_conversion_from_1((amount - fee).raw()));
+    }
+    return amount;
+  });
+  run("handle", [&](Amount amount) {
+    return convert_along(legs, amount);
+  });
+  return 0;
+}
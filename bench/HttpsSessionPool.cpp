@@ -0,0 +1,156 @@
+// REST round trips against a local TLS stand-in for api.kraken.com: a fresh
+// HTTPSClientSession per request (handshake included) against HttpsSessionPool.
+// Then the stand-in is restarted and the pool has to reconnect on its own.
+//
+//   openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=localhost -keyout key.pem -out cert.pem
+//   booker_https_pool_bench key.pem cert.pem
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <Poco/Net/AcceptCertificateHandler.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/NetSSL.h>
+#include <Poco/Net/SSLManager.h>
+#include <Poco/Net/SecureServerSocket.h>
+#include <Poco/StreamCopier.h>
+
+#include "connector/trade/HttpsSessionPool.hpp"
+
+namespace {
+const size_t requests = 200;
+const char* const order_path = "/0/private/AddOrder";
+const std::string order_content = "nonce=1&pair=XBTUSD&type=buy&ordertype=market&volume=0.1";
+const std::string order_reply = R"({"error":[],"result":{"txid":["STANDIN"]}})";
+
+class StandInHandler : public Poco::Net::HTTPRequestHandler {
+public:
+  void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override {
+    std::string ignored;
+    Poco::StreamCopier::copyToString(request.stream(), ignored);
+    std::string reply = request.getURI() == order_path ? order_reply : R"({"error":[],"result":{"unixtime":0}})";
+    response.setContentType("application/json");
+    response.setContentLength(reply.size());
+    response.send() << reply;
+  }
+};
+
+class StandInFactory : public Poco::Net::HTTPRequestHandlerFactory {
+public:
+  Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&) override {
+    return new StandInHandler;
+  }
+};
+
+std::unique_ptr<Poco::Net::HTTPServer> start_stand_in(Poco::Net::Context::Ptr context, unsigned short port) {
+  Poco::Net::SecureServerSocket socket(Poco::Net::SocketAddress("127.0.0.1", port), 64, context);
+  Poco::Net::HTTPServerParams::Ptr params = new Poco::Net::HTTPServerParams;
+  params->setKeepAlive(true);
+  params->setMaxKeepAliveRequests(0);
+  params->setKeepAliveTimeout(Poco::Timespan(60, 0));
+  auto server = std::make_unique<Poco::Net::HTTPServer>(new StandInFactory, socket, params);
+  server->start();
+  return server;
+}
+
+Poco::Net::HTTPRequest order_request() {
+  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, order_path, Poco::Net::HTTPMessage::HTTP_1_1);
+  request.setContentType("application/x-www-form-urlencoded");
+  return request;
+}
+
+// send() returns whether the stand-in's order reply came back, the count of
+// those that did not is returned.
+template <class Send>
+size_t run(const char* name, Send&& send) {
+  size_t failed = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < requests; i++)
+    failed += !send();
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << " us_per_request=" << us / requests << " failed=" << failed << std::endl;
+  return failed;
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <key.pem> <cert.pem>" << std::endl;
+    return 1;
+  }
+  Poco::Net::initializeSSL();
+  Poco::Net::Context::Ptr server_context =
+      new Poco::Net::Context(Poco::Net::Context::TLS_SERVER_USE, argv[1], argv[2], "", Poco::Net::Context::VERIFY_NONE);
+  Poco::Net::Context::Ptr client_context =
+      new Poco::Net::Context(Poco::Net::Context::TLS_CLIENT_USE, "", "", "", Poco::Net::Context::VERIFY_NONE);
+  Poco::SharedPtr<Poco::Net::InvalidCertificateHandler> accept_all = new Poco::Net::AcceptCertificateHandler(false);
+  Poco::Net::SSLManager::instance().initializeClient(nullptr, accept_all, client_context);
+
+  std::unique_ptr<Poco::Net::HTTPServer> server = start_stand_in(server_context, 0);
+  const unsigned short port = server->port();
+
+  HttpsSessionPool::Options options;
+  options.host = "127.0.0.1";
+  options.port = port;
+  options.size = 2;
+  options.context = client_context;
+  options.ping_interval = std::chrono::seconds(1);
+  HttpsSessionPool pool(options);
+  const auto connecting = std::chrono::steady_clock::now();
+  while (pool.healthy_sessions() < options.size) {
+    if (std::chrono::steady_clock::now() - connecting > std::chrono::seconds(10)) {
+      std::cout << "FAIL pool never connected to the stand-in" << std::endl;
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  size_t failed = run("fresh_session", [&] {
+    Poco::Net::HTTPSClientSession session("127.0.0.1", port, client_context);
+    Poco::Net::HTTPRequest request = order_request();
+    request.setContentLength(order_content.size());
+    session.sendRequest(request) << order_content;
+    Poco::Net::HTTPResponse response;
+    std::string content;
+    Poco::StreamCopier::copyToString(session.receiveResponse(response), content);
+    return response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK && content == order_reply;
+  });
+  failed += run("pooled_session", [&] {
+    Poco::Net::HTTPRequest request = order_request();
+    std::string content;
+    return pool.send(request, order_content, content) == Poco::Net::HTTPResponse::HTTP_OK && content == order_reply;
+  });
+
+  // Kill every connection, bring the stand-in back and wait for the pool to notice.
+  server->stopAll(true);
+  server.reset();
+  server = start_stand_in(server_context, port);
+  auto restarted = std::chrono::steady_clock::now();
+  // Both stale sessions get pinged, fail and are reconnected by then.
+  std::this_thread::sleep_for(options.ping_interval * 2);
+  bool recovered = false;
+  while (!recovered && std::chrono::steady_clock::now() - restarted < std::chrono::seconds(10)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    recovered = pool.healthy_sessions() == options.size;
+  }
+  Poco::Net::HTTPRequest request = order_request();
+  std::string content;
+  bool sent = recovered && pool.send(request, order_content, content) == Poco::Net::HTTPResponse::HTTP_OK
+              && content == order_reply;
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restarted).count();
+  std::cout << "reconnect recovered=" << sent << " ms=" << ms << std::endl;
+
+  server->stopAll(true);
+  Poco::Net::uninitializeSSL();
+  const bool passed = failed == 0 && sent;
+  std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+  return passed ? 0 : 1;
+}
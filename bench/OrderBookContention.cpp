@@ -0,0 +1,102 @@
+// N reader threads hammer estimate_conversion_from_1/2 while one writer replays
+// level updates, once per storage. Map storage takes the mutex on both sides,
+// flat storage lets readers retry under the seqlock.
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "LeveledOrderBook.hpp"
+
+namespace {
+struct BenchOrderBook : public LeveledOrderBook {
+  using LeveledOrderBook::LeveledOrderBook;
+  using LeveledOrderBook::apply_updates;
+  using LeveledOrderBook::updateAskLevel;
+  using LeveledOrderBook::updateBidLevel;
+};
+
+struct Update {
+  bool ask;
+  Amount price;
+  Amount volume;
+};
+
+std::vector<Update> make_updates(size_t count, size_t depth) {
+  std::mt19937_64 rng(42);
+  std::vector<Update> updates;
+  updates.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    bool ask = rng() & 1;
+    int64_t offset = int64_t(rng() % (depth * 2));
+    Amount price = Amount::from_integer(ask ? 30001 + offset : 29999 - offset);
+    Amount volume = rng() % 5 == 0 ? Amount() : Amount::from_raw(rng() % (10 * Amount::one) + 1);
+    updates.push_back({ask, price, volume});
+  }
+  return updates;
+}
+
+void run(BookStorage storage, size_t depth, unsigned readers, const std::vector<Update>& updates) {
+  const Symbol& xbt = SymbolFactory::get_factory().get_symbol("XBT", "bench");
+  const Symbol& usd = SymbolFactory::get_factory().get_symbol("USD", "bench");
+  BenchOrderBook ob(xbt, usd, decimals, decimals, depth, storage);
+  std::vector<LevelUpdate> snapshot;
+  for (size_t i = 0; i < depth; i++) {
+    snapshot.push_back({BookSide::Ask, Amount::from_integer(30001 + i), Amount::from_integer(1)});
+    snapshot.push_back({BookSide::Bid, Amount::from_integer(29999 - i), Amount::from_integer(1)});
+  }
+  ob.apply_updates(snapshot, true);
+
+  std::atomic<bool> running{true};
+  std::atomic<uint64_t> reads{0};
+  std::vector<std::thread> threads;
+  for (unsigned r = 0; r < readers; r++) {
+    threads.emplace_back([&]() {
+      uint64_t local = 0;
+      __int128 sink = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        sink += ob.estimate_conversion_from_1(3 * Amount::one);
+        sink += ob.estimate_conversion_from_2(90000 * Amount::one);
+        local += 2;
+      }
+      reads += local + (sink == 42);
+    });
+  }
+
+  std::chrono::nanoseconds worst{0};
+  auto start = std::chrono::steady_clock::now();
+  for (const Update& u : updates) {
+    auto before = std::chrono::steady_clock::now();
+    if (u.ask)
+      ob.updateAskLevel(u.price, u.volume);
+    else
+      ob.updateBidLevel(u.price, u.volume);
+    worst = std::max(worst, std::chrono::steady_clock::now() - before);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  running = false;
+  for (auto& t : threads)
+    t.join();
+
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  std::cout << (storage == BookStorage::Flat ? "flat/seqlock" : "map/mutex")
+            << " depth=" << depth << " readers=" << readers
+            << " writer_updates_per_s=" << uint64_t(updates.size() / seconds)
+            << " writer_worst_ns=" << worst.count()
+            << " reads_per_s=" << uint64_t(reads.load() / seconds) << std::endl;
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  unsigned max_readers = argc > 1 ? std::stoi(argv[1]) : std::max(1u, std::thread::hardware_concurrency() - 1);
+  for (size_t depth : {10, 100}) {
+    std::vector<Update> updates = make_updates(2000000, depth);
+    for (unsigned readers = 0; readers <= max_readers; readers = readers == 0 ? 1 : readers * 2) {
+      run(BookStorage::Map, depth, readers, updates);
+      run(BookStorage::Flat, depth, readers, updates);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// get_order_book lookups over a synthetic 700 pair market: the former string
+// keyed resolver path against the dense id TradingPairTable.
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TradingPairTable.hpp"
+
+namespace {
+const size_t symbol_count = 400;
+const size_t pair_count = 700;
+const size_t lookups = 5000000;
+
+struct Market {
+  std::vector<std::reference_wrapper<const Symbol>> symbols;
+  std::map<std::string, LeveledOrderBook, std::less<>> trading_pairs;
+  std::map<std::string, ReverseOrderBook> reverse_order_books;
+  std::map<std::pair<std::string, std::string>, std::string> trading_pair_resolver;
+  TradingPairTable pair_table;
+
+  // Former KrakenExchange::get_order_book.
+  const GenericOrderBook& lookup_by_name(const Symbol& symbol1, const Symbol& symbol2) {
+    if (trading_pair_resolver.count({symbol1.get_symbol(), symbol2.get_symbol()}) > 0) {
+      const std::string pair_name = trading_pair_resolver[{symbol1.get_symbol(), symbol2.get_symbol()}];
+      return trading_pairs.find(pair_name)->second;
+    }
+    const std::string pair_name = trading_pair_resolver[{symbol2.get_symbol(), symbol1.get_symbol()}];
+    return reverse_order_books.find(pair_name)->second;
+  }
+};
+
+template <class Lookup>
+void run(const char* name, const std::vector<std::pair<size_t, size_t>>& queries, const Market& market, Lookup&& lookup) {
+  uintptr_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < lookups; i++) {
+    const auto& [a, b] = queries[i % queries.size()];
+    sink ^= reinterpret_cast<uintptr_t>(&lookup(market.symbols[a], market.symbols[b]));
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << " ns_per_lookup=" << ns / lookups << " (" << (sink & 1) << ")" << std::endl;
+}
+} //namespace
+
+int main() {
+  SymbolFactory& factory = SymbolFactory::get_factory();
+  Market market;
+  for (size_t i = 0; i < symbol_count; i++)
+    market.symbols.push_back(factory.get_symbol("S" + std::to_string(i), "bench"));
+
+  std::mt19937 rng(7);
+  std::vector<std::pair<size_t, size_t>> queries;
+  while (market.trading_pairs.size() < pair_count) {
+    size_t a = rng() % symbol_count, b = rng() % symbol_count;
+    const Symbol& s1 = market.symbols[a];
+    const Symbol& s2 = market.symbols[b];
+    std::string name = s1.get_symbol() + "/" + s2.get_symbol();
+    if (a == b || market.trading_pair_resolver.count({s2.get_symbol(), s1.get_symbol()}) > 0 || market.trading_pairs.count(name) > 0)
+      continue;
+    auto ob_it = market.trading_pairs.insert(std::make_pair(name, LeveledOrderBook(s1, s2))).first;
+    market.reverse_order_books.insert(std::make_pair(name, ReverseOrderBook(ob_it->second)));
+    market.trading_pair_resolver.insert({{s1.get_symbol(), s2.get_symbol()}, name});
+    queries.push_back({a, b});
+    queries.push_back({b, a});
+  }
+  std::shuffle(queries.begin(), queries.end(), rng);
+
+  market.pair_table.reset(factory.count());
+  for (const auto& [name, ob] : market.trading_pairs)
+    market.pair_table.add(ob, market.reverse_order_books.find(name)->second);
+
+  run("string_resolver", queries, market, [&](const Symbol& s1, const Symbol& s2) -> const GenericOrderBook& {
+    return market.lookup_by_name(s1, s2);
+  });
+  run("pair_table", queries, market, [&](const Symbol& s1, const Symbol& s2) -> const GenericOrderBook& {
+    return *market.pair_table.find(s1, s2)->generic;
+  });
+  return 0;
+}
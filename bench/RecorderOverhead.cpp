@@ -0,0 +1,161 @@
+// Cost of MarketRecorder on the ingest path: parses and applies synthetic Kraken
+// book frames like process_ws does, with recording off, raw and columnar, then
+// reads the recording back to check it and to compare file sizes.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LeveledOrderBook.hpp"
+#include "connector/input/KrakenBookParser.hpp"
+#include "connector/input/MarketRecorder.hpp"
+
+namespace {
+struct BenchOrderBook : public LeveledOrderBook {
+  using LeveledOrderBook::LeveledOrderBook;
+  using LeveledOrderBook::apply_updates;
+};
+
+static const char* const pairs[] = {"XBT/USD", "ETH/USD", "ETH/XBT", "SOL/EUR", "XRP/USD", "ADA/EUR", "DOT/USD", "LTC/XBT"};
+
+std::string price_text(int64_t ticks) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%lld.%05lld", static_cast<long long>(ticks / 100000), static_cast<long long>(ticks % 100000));
+  return text;
+}
+
+// One snapshot per pair, then deltas of one to three levels near the top.
+std::vector<std::string> make_frames(size_t count, size_t depth) {
+  std::mt19937_64 rng(7);
+  std::vector<std::string> frames;
+  const size_t pair_count = std::size(pairs);
+  for (size_t p = 0; p < pair_count; p++) {
+    std::string asks, bids;
+    for (size_t i = 0; i < depth; i++) {
+      asks += std::string(i ? "," : "") + "[\"" + price_text(3000000000 + i * 10) + "\",\"1.50000000\",\"1700000000.000000\"]";
+      bids += std::string(i ? "," : "") + "[\"" + price_text(2999999990 - i * 10) + "\",\"2.00000000\",\"1700000000.000000\"]";
+    }
+    frames.push_back("[" + std::to_string(300 + p) + ",{\"as\":[" + asks + "],\"bs\":[" + bids + "]},\"book-"
+                     + std::to_string(depth) + "\",\"" + pairs[p] + "\"]");
+  }
+  while (frames.size() < count) {
+    size_t p = rng() % pair_count;
+    bool ask = rng() & 1;
+    std::string levels;
+    for (size_t n = 1 + rng() % 3, i = 0; i < n; i++) {
+      int64_t offset = int64_t(rng() % (depth * 10));
+      int64_t ticks = ask ? 3000000000 + offset : 2999999990 - offset;
+      std::string volume = rng() % 5 == 0 ? "0.00000000" : "0." + std::to_string(10000000 + rng() % 90000000);
+      levels += std::string(i ? "," : "") + "[\"" + price_text(ticks) + "\",\"" + volume + "\",\"1700000001.123456\"]";
+    }
+    frames.push_back("[" + std::to_string(300 + p) + ",{\"" + (ask ? "a" : "b") + "\":[" + levels + "],\"c\":\"12345\"},\"book-"
+                     + std::to_string(depth) + "\",\"" + pairs[p] + "\"]");
+  }
+  return frames;
+}
+
+struct Result {
+  double mean_ns;
+  double p99_ns;
+  double p999_ns;
+};
+
+Result ingest(const std::vector<std::string>& frames, size_t depth, MarketRecorder* recorder) {
+  const Symbol& base = SymbolFactory::get_factory().get_symbol("BASE", "bench");
+  const Symbol& quote = SymbolFactory::get_factory().get_symbol("QUOTE", "bench");
+  std::map<std::string, BenchOrderBook, std::less<>> books;
+  for (const char* pair : pairs)
+    books.try_emplace(pair, base, quote, 5, 8, depth);
+
+  KrakenBookFrame frame;
+  std::vector<LevelUpdate> updates;
+  std::vector<uint32_t> samples;
+  samples.reserve(frames.size());
+  const auto start = std::chrono::steady_clock::now();
+  for (const std::string& text : frames) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t receive_ns = recorder ? MarketRecorder::now_ns() : 0;
+    if (recorder)
+      recorder->record_frame(receive_ns, text.data(), text.size());
+    if (!parse_kraken_book_frame(text.data(), text.size(), frame))
+      continue;
+    updates.clear();
+    for (const KrakenBookLevel& level : frame.levels) {
+      LevelUpdate update{level.side, {}, {}};
+      if (Amount::parse(level.price, update.price) && Amount::parse(level.volume, update.volume))
+        updates.push_back(update);
+    }
+    if (recorder)
+      recorder->record_levels(receive_ns, frame.pair, frame.snapshot, updates);
+    books.find(frame.pair)->second.apply_updates(updates, frame.snapshot);
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+  }
+  const double total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::sort(samples.begin(), samples.end());
+  return {total / frames.size(), double(samples[samples.size() * 99 / 100]), double(samples[samples.size() * 999 / 1000])};
+}
+
+// Frames and levels read back, and the size of all parts.
+void check(const std::string& path, size_t& frames, size_t& levels, uintmax_t& bytes) {
+  frames = levels = bytes = 0;
+  RecordedFrame frame;
+  for (const std::string& part : recording_parts(path)) {
+    bytes += std::filesystem::file_size(part);
+    MarketRecordingReader reader(part);
+    while (reader.next(frame)) {
+      frames++;
+      levels += frame.levels.size();
+    }
+  }
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  const size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t depth = 25;
+  const std::string directory = (std::filesystem::temp_directory_path() / "booker_recorder_bench").string();
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+
+  std::vector<std::string> frames = make_frames(count, depth);
+  size_t text_bytes = 0;
+  for (const std::string& frame : frames)
+    text_bytes += frame.size();
+  std::cout << frames.size() << " frames, " << text_bytes / frames.size() << " bytes per frame on average\n";
+  if (std::thread::hardware_concurrency() < 2)
+    std::cout << "Single CPU: the writer thread competes with ingest, overheads include its encoding\n";
+
+  Result off = ingest(frames, depth, nullptr);
+  std::printf("%-9s %8.1f ns/frame  p99 %6.0f ns  p99.9 %6.0f ns\n", "off", off.mean_ns, off.p99_ns, off.p999_ns);
+
+  for (RecordingFormat format : {RecordingFormat::Raw, RecordingFormat::Columnar}) {
+    const char* name = format == RecordingFormat::Raw ? "raw" : "columnar";
+    MarketRecorder::Options options;
+    options.path = directory + "/" + name;
+    options.format = format;
+    options.rotate_bytes = 64 << 20;
+    Result on;
+    uint64_t dropped;
+    {
+      MarketRecorder recorder(options);
+      on = ingest(frames, depth, &recorder);
+      dropped = recorder.dropped();
+    }
+    size_t read_frames, read_levels;
+    uintmax_t bytes;
+    check(options.path, read_frames, read_levels, bytes);
+    std::printf("%-9s %8.1f ns/frame  p99 %6.0f ns  p99.9 %6.0f ns  +%.1f ns  dropped %llu  read back %zu frames"
+                "  %.1f bytes/frame\n",
+                name, on.mean_ns, on.p99_ns, on.p999_ns, on.mean_ns - off.mean_ns,
+                static_cast<unsigned long long>(dropped), read_frames, double(bytes) / read_frames);
+    if (read_frames + dropped != frames.size())
+      std::cout << "  MISMATCH: expected " << frames.size() - dropped << " frames\n";
+  }
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,187 @@
+// Book feed throughput by number of feed shards: every shard thread parses and
+// applies the frames of its pairs like process_ws does and queues the changed
+// books for one strategy thread, which drains the queue. Pair rates are skewed,
+// shards start round robin and are then evened out with plan_shard_moves.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BookChangeQueue.hpp"
+#include "LeveledOrderBook.hpp"
+#include "connector/input/KrakenBookParser.hpp"
+#include "connector/input/KrakenFeedShard.hpp"
+
+namespace {
+struct BenchOrderBook : public LeveledOrderBook {
+  using LeveledOrderBook::LeveledOrderBook;
+  using LeveledOrderBook::apply_updates;
+};
+
+const size_t pair_count = 256;
+const size_t depth = 25;
+
+std::string price_text(int64_t ticks) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%lld.%05lld", static_cast<long long>(ticks / 100000), static_cast<long long>(ticks % 100000));
+  return text;
+}
+
+std::string pair_name(size_t p) {
+  return "P" + std::to_string(p) + "/USD";
+}
+
+struct Frame {
+  size_t pair;
+  std::string text;
+};
+
+// A snapshot per pair, then deltas with Zipf distributed pairs: a few pairs
+// carry most of the traffic, as on the real feed.
+std::vector<Frame> make_frames(size_t count) {
+  std::mt19937_64 rng(11);
+  std::vector<double> weights;
+  for (size_t p = 0; p < pair_count; p++)
+    weights.push_back(1.0 / std::pow(p + 1, 0.8));
+  std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+  std::vector<Frame> frames;
+  for (size_t p = 0; p < pair_count; p++) {
+    std::string asks, bids;
+    for (size_t i = 0; i < depth; i++) {
+      asks += std::string(i ? "," : "") + "[\"" + price_text(3000000000 + i * 10) + "\",\"1.50000000\",\"1700000000.000000\"]";
+      bids += std::string(i ? "," : "") + "[\"" + price_text(2999999990 - i * 10) + "\",\"2.00000000\",\"1700000000.000000\"]";
+    }
+    frames.push_back({p, "[" + std::to_string(p) + ",{\"as\":[" + asks + "],\"bs\":[" + bids + "]},\"book-"
+                         + std::to_string(depth) + "\",\"" + pair_name(p) + "\"]"});
+  }
+  while (frames.size() < count) {
+    size_t p = pick(rng);
+    bool ask = rng() & 1;
+    std::string levels;
+    for (size_t n = 1 + rng() % 3, i = 0; i < n; i++) {
+      int64_t offset = int64_t(rng() % (depth * 10));
+      int64_t ticks = ask ? 3000000000 + offset : 2999999990 - offset;
+      std::string volume = rng() % 5 == 0 ? "0.00000000" : "0." + std::to_string(10000000 + rng() % 90000000);
+      levels += std::string(i ? "," : "") + "[\"" + price_text(ticks) + "\",\"" + volume + "\",\"1700000001.123456\"]";
+    }
+    frames.push_back({p, "[" + std::to_string(p) + ",{\"" + (ask ? "a" : "b") + "\":[" + levels + "]},\"book-"
+                         + std::to_string(depth) + "\",\"" + pair_name(p) + "\"]"});
+  }
+  return frames;
+}
+
+// Busiest shard over the mean, 1 is perfectly even.
+double imbalance(const std::vector<uint64_t>& rates, const std::vector<uint32_t>& writers, uint32_t shards) {
+  std::vector<uint64_t> loads(shards, 0);
+  uint64_t total = 0;
+  for (size_t p = 0; p < rates.size(); p++) {
+    loads[writers[p]] += rates[p];
+    total += rates[p];
+  }
+  return double(*std::max_element(loads.begin(), loads.end())) * shards / total;
+}
+
+// Frames per second through `shards` ingest threads with the given pair split.
+double ingest(const std::vector<Frame>& frames, const std::vector<uint32_t>& writers, uint32_t shards) {
+  const Symbol& base = SymbolFactory::get_factory().get_symbol("BASE", "bench");
+  const Symbol& quote = SymbolFactory::get_factory().get_symbol("QUOTE", "bench");
+  std::vector<std::unique_ptr<BenchOrderBook>> books;
+  for (size_t p = 0; p < pair_count; p++)
+    books.push_back(std::make_unique<BenchOrderBook>(base, quote, 5, 8, depth));
+
+  // What each shard's socket would deliver, in feed order.
+  std::vector<std::vector<const Frame*>> shard_frames(shards);
+  for (const Frame& frame : frames)
+    shard_frames[writers[frame.pair]].push_back(&frame);
+
+  BookChangeQueue queue;
+  std::atomic<uint32_t> running{shards};
+  std::thread strategy([&] {
+    std::vector<const LeveledOrderBook*> changed;
+    while (running.load(std::memory_order_acquire) > 0 || queue.wait(changed, std::chrono::milliseconds(0)))
+      queue.wait(changed, std::chrono::milliseconds(1));
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (uint32_t s = 0; s < shards; s++) {
+    threads.emplace_back([&, s] {
+      KrakenBookFrame frame;
+      std::vector<LevelUpdate> updates;
+      for (const Frame* f : shard_frames[s]) {
+        if (!parse_kraken_book_frame(f->text.data(), f->text.size(), frame))
+          continue;
+        updates.clear();
+        for (const KrakenBookLevel& level : frame.levels) {
+          LevelUpdate update{level.side, {}, {}};
+          if (Amount::parse(level.price, update.price) && Amount::parse(level.volume, update.volume))
+            updates.push_back(update);
+        }
+        BenchOrderBook& book = *books[f->pair];
+        book.apply_updates(updates, frame.snapshot);
+        queue.push(book);
+      }
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  strategy.join();
+  return frames.size() / seconds;
+}
+} //namespace
+
+int main(int argc, char** argv) {
+  const size_t count = argc > 1 ? std::stoul(argv[1]) : 2000000;
+  const std::vector<Frame> frames = make_frames(count);
+  std::vector<uint64_t> rates(pair_count, 0);
+  for (const Frame& frame : frames)
+    rates[frame.pair]++;
+
+  const unsigned cpus = std::thread::hardware_concurrency();
+  std::cout << frames.size() << " frames over " << pair_count << " pairs, " << cpus << " CPUs\n";
+  if (cpus < 2)
+    std::cout << "Single CPU: shards share it, no scaling to expect\n";
+
+  // Best of three runs, threads start at slightly different times.
+  auto best_ingest = [&](const std::vector<uint32_t>& writers, uint32_t shards) {
+    double best = 0;
+    for (int run = 0; run < 3; run++)
+      best = std::max(best, ingest(frames, writers, shards));
+    return best;
+  };
+  double single = 0;
+  for (uint32_t shards = 1; shards <= std::max(8u, cpus); shards *= 2) {
+    std::vector<uint32_t> writers(pair_count);
+    for (size_t p = 0; p < pair_count; p++)
+      writers[p] = p % shards;
+    const double before = imbalance(rates, writers, shards);
+    const double round_robin = best_ingest(writers, shards);
+
+    size_t moved = 0;
+    for (int round = 0; round < 16; round++) {
+      std::vector<ShardMove> moves = plan_shard_moves(rates, writers, shards, 8, 0.05);
+      if (moves.empty())
+        break;
+      for (const ShardMove& move : moves)
+        writers[move.pair] = move.to;
+      moved += moves.size();
+    }
+    const double after = imbalance(rates, writers, shards);
+    const double balanced = best_ingest(writers, shards);
+    if (shards == 1)
+      single = balanced;
+    std::printf("%2u shards  round robin %10.0f frames/s (imbalance %.2f)  rebalanced %10.0f frames/s (imbalance %.2f,"
+                " %zu moves)  x%.2f\n",
+                shards, round_robin, before, balanced, after, moved, balanced / single);
+  }
+}
@@ -0,0 +1,78 @@
+// Sizing one mispriced USD -> XBT -> ETH -> USD cycle: CycleSizeSolver against a
+// grid search over trade sizes, profit reached and time per cycle for each.
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "strategy/CycleSizeSolver.hpp"
+
+namespace {
+const size_t depth = 25;
+const size_t rounds = 20000;
+
+struct BenchOrderBook : public LeveledOrderBook {
+  BenchOrderBook(const Symbol& s1, const Symbol& s2) : LeveledOrderBook(s1, s2, decimals, decimals, depth) {}
+  using LeveledOrderBook::apply_updates;
+};
+
+// `depth` levels per side around mid, spread `step` apart with random volumes.
+void seed(BenchOrderBook& book, Amount ask, Amount bid, Amount step, std::mt19937_64& rng) {
+  std::vector<LevelUpdate> levels;
+  for (size_t i = 0; i < depth; i++) {
+    Amount offset = Amount::from_raw(step.raw() * i);
+    levels.push_back({BookSide::Ask, ask + offset, Amount::from_raw(rng() % (2 * Amount::one) + Amount::one / 10)});
+    levels.push_back({BookSide::Bid, bid - offset, Amount::from_raw(rng() % (2 * Amount::one) + Amount::one / 10)});
+  }
+  book.apply_updates(levels, true);
+}
+
+template <class Solve>
+void run(const char* name, Solve&& solve) {
+  Amount profit;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < rounds; i++)
+    profit = solve();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << name << " ns_per_cycle=" << ns / rounds << " profit=" << profit.to_string() << std::endl;
+}
+} //namespace
+
+int main() {
+  SymbolFactory& factory = SymbolFactory::get_factory();
+  const Symbol& usd = factory.get_symbol("USD", "bench");
+  const Symbol& xbt = factory.get_symbol("XBT", "bench");
+  const Symbol& eth = factory.get_symbol("ETH", "bench");
+
+  std::mt19937_64 rng(12);
+  BenchOrderBook xbt_usd(xbt, usd), eth_xbt(eth, xbt), eth_usd(eth, usd);
+  // Buying ETH through XBT costs ~1500 USD, selling it directly fetches ~1520.
+  seed(xbt_usd, Amount::from_integer(30000), Amount::from_integer(29990), Amount::from_integer(5), rng);
+  seed(eth_xbt, Amount::from_string("0.05"), Amount::from_string("0.0499"), Amount::from_string("0.0001"), rng);
+  seed(eth_usd, Amount::from_integer(1530), Amount::from_integer(1520), Amount::from_integer(2), rng);
+  ReverseOrderBook usd_xbt(xbt_usd), xbt_eth(eth_xbt);
+
+  const BookHandle legs[] = {{&xbt_usd, true, &usd_xbt}, {&eth_xbt, true, &xbt_eth}, {&eth_usd, false, &eth_usd}};
+  // The grid spans about what the thinnest leg can absorb.
+  const Amount max_in = Amount::from_integer(60000);
+
+  CycleSizeSolver solver;
+  run("solver", [&] {
+    CycleSizeSolver::Result result = solver.solve(legs);
+    return result.amount_out - result.amount_in;
+  });
+  for (size_t samples : {16, 256, 4096}) {
+    std::string name = "grid_" + std::to_string(samples);
+    run(name.c_str(), [&] {
+      Amount best;
+      for (size_t k = 1; k <= samples; k++) {
+        Amount amount_in = Amount::from_raw(max_in.raw() * k / samples);
+        Amount profit = convert_along(legs, amount_in) - amount_in;
+        if (profit > best)
+          best = profit;
+      }
+      return best;
+    });
+  }
+  return 0;
+}
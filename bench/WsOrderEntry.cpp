@@ -0,0 +1,161 @@
+// Offline round trip of KrakenWsTrading against a local mock of ws-auth.kraken.com.
+// The mock answers addOrder with addOrderStatus, rejects zero volume orders and
+// can hold replies back and answer a batch in reverse order, so reqid matching
+// is exercised too.
+//
+//   booker_ws_order_bench            runs the checks and the latency measurement
+//   booker_ws_order_bench --serve N  only runs the mock on port N, point Booker at
+//                                    it with Kraken.OrderEntryHost/Port/Secure
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <Poco/Buffer.h>
+#include <Poco/JSON/Object.h>
+#include <Poco/JSON/Parser.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/WebSocket.h>
+
+#include "connector/trade/KrakenWsTrading.hpp"
+
+namespace {
+const size_t sequential_orders = 2000;
+const size_t batch_orders = 64;
+
+// Replies are sent once this many addOrders are held, newest first.
+std::atomic<size_t> reply_batch{1};
+// Orders waited for this long count as lost, a broken reqid match fails the run
+// instead of hanging it.
+const auto reply_timeout = std::chrono::seconds(5);
+
+// The txid carries the order's volume, so each result can be checked against
+// the order it belongs to.
+std::string order_status(const Poco::JSON::Object::Ptr& order) {
+  std::string reqid = std::to_string(order->getValue<uint64_t>("reqid"));
+  std::string volume = order->getValue<std::string>("volume");
+  if (volume == "0")
+    return R"({"event":"addOrderStatus","reqid":)" + reqid + R"(,"status":"error","errorMessage":"EOrder:Invalid volume"})";
+  return R"({"event":"addOrderStatus","reqid":)" + reqid + R"(,"status":"ok","txid":"OMOCK-)" + volume
+         + R"(","descr":"mock"})";
+}
+
+bool ready(std::future<OrderResult>& future) {
+  return future.wait_for(reply_timeout) == std::future_status::ready;
+}
+
+class MockOrderEntryHandler : public Poco::Net::HTTPRequestHandler {
+public:
+  void handleRequest(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response) override {
+    Poco::Net::WebSocket ws(request, response);
+    Poco::Buffer<char> buffer(0);
+    std::vector<std::string> held;
+    int flags = 0;
+    int n = 0;
+    do {
+      buffer.resize(0);
+      n = ws.receiveFrame(buffer, flags);
+      if (n <= 0 || (flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) != Poco::Net::WebSocket::FRAME_OP_TEXT)
+        continue;
+      Poco::JSON::Parser parser;
+      Poco::JSON::Object::Ptr message = parser.parse(std::string(buffer.begin(), n)).extract<Poco::JSON::Object::Ptr>();
+      std::string event = message->getValue<std::string>("event");
+      if (event == "ping") {
+        std::string pong = R"({"event":"pong"})";
+        ws.sendFrame(pong.data(), pong.size());
+      } else if (event == "addOrder") {
+        held.push_back(order_status(message));
+        if (held.size() >= reply_batch) {
+          for (auto it = held.rbegin(); it != held.rend(); ++it)
+            ws.sendFrame(it->data(), it->size());
+          held.clear();
+        }
+      }
+    } while (n > 0 && (flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) != Poco::Net::WebSocket::FRAME_OP_CLOSE);
+  }
+};
+
+class MockFactory : public Poco::Net::HTTPRequestHandlerFactory {
+public:
+  Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&) override {
+    return new MockOrderEntryHandler;
+  }
+};
+} //namespace
+
+int main(int argc, char** argv) {
+  unsigned short port = argc == 3 && std::strcmp(argv[1], "--serve") == 0 ? std::stoi(argv[2]) : 0;
+  Poco::Net::ServerSocket socket(Poco::Net::SocketAddress("127.0.0.1", port));
+  Poco::Net::HTTPServer server(new MockFactory, socket, new Poco::Net::HTTPServerParams);
+  server.start();
+  if (port != 0) {
+    std::cout << "Mock order entry listening on ws://127.0.0.1:" << port << std::endl;
+    while (true)
+      std::this_thread::sleep_for(std::chrono::hours(1));
+  }
+
+  KrakenWsTrading::Options options;
+  options.host = "127.0.0.1";
+  options.port = server.port();
+  options.secure = false;
+  size_t tokens = 0;
+  KrakenWsTrading trading(options, [&] { return "mock-token-" + std::to_string(++tokens); });
+  trading.start();
+  const auto connecting = std::chrono::steady_clock::now();
+  while (!trading.connected()) {
+    if (std::chrono::steady_clock::now() - connecting > std::chrono::seconds(10)) {
+      std::cout << "FAIL never connected to the mock" << std::endl;
+      server.stopAll(true);
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t accepted = 0;
+  for (size_t i = 0; i < sequential_orders; i++) {
+    std::optional<std::future<OrderResult>> sent = trading.add_order("XBT/USD", "buy", "0.1");
+    if (!sent || !ready(*sent))
+      break;
+    accepted += sent->get().ok;
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "sequential us_per_order=" << us / sequential_orders << " accepted=" << accepted << std::endl;
+
+  // Volumes identify the orders, replies come back in reverse.
+  reply_batch = batch_orders;
+  std::vector<std::future<OrderResult>> futures;
+  std::atomic<size_t> callbacks{0};
+  for (size_t i = 0; i < batch_orders; i++) {
+    std::string volume = i % 8 == 7 ? "0" : std::to_string(i + 1);
+    std::optional<std::future<OrderResult>> sent =
+        trading.add_order("XBT/USD", i % 2 ? "sell" : "buy", volume, [&](const OrderResult&) { callbacks++; });
+    if (!sent)
+      break;
+    futures.push_back(std::move(*sent));
+  }
+  size_t matched = 0;
+  for (size_t i = 0; i < futures.size(); i++) {
+    if (!ready(futures[i]))
+      break;
+    OrderResult result = futures[i].get();
+    bool rejected = i % 8 == 7;
+    matched += rejected ? !result.ok && !result.errors.empty()
+                        : result.ok && result.txids == std::vector<std::string>{"OMOCK-" + std::to_string(i + 1)};
+  }
+  std::cout << "reordered_batch matched=" << matched << "/" << batch_orders << " callbacks=" << callbacks << std::endl;
+
+  server.stopAll(true);
+  const bool passed = accepted == sequential_orders && matched == batch_orders && callbacks == batch_orders;
+  std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#pragma once
+
+class LeveledOrderBook;
+
+// Books changed by the ingest thread(s), handed over to a strategy thread. Each
+// book is queued at most once until the consumer picks it up, so a busy pair
+// cannot flood the queue.
+class BookChangeQueue {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<const LeveledOrderBook*> pending;
+public:
+  void push(const LeveledOrderBook& book);
+
+  // Blocks until at least one book changed or the timeout expires. Replaces the
+  // content of `books` with the changed ones and returns false on timeout.
+  bool wait(std::vector<const LeveledOrderBook*>& books, std::chrono::milliseconds timeout);
+};
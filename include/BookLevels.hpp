@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <vector>
+#include "constants.hpp"
+#include "LevelSearch.hpp"
+
+#pragma once
+
+// Storage used for the levels of a LeveledOrderBook, selectable per book so the
+// two can be benchmarked against each other.
+enum class BookStorage { Map, Flat };
+
+// Both sides below keep levels best first: asks use std::less, bids std::greater.
+// for_each() visits levels in that order until the visitor returns false.
+// commit() is called once after a batch of updates, before readers see them.
+
+template <class Better>
+class MapBookSide {
+  std::map<Amount, Amount, Better> levels;
+  size_t depth;
+public:
+  explicit MapBookSide(size_t depth) : depth(depth) {}
+
+  void update(Amount price, Amount volume) {
+    if (volume.is_zero()) {
+      levels.erase(price);
+      return;
+    }
+    levels[price] = volume;
+    if (levels.size() > depth)
+      levels.erase(std::prev(levels.end()));
+  }
+
+  void clear() { levels.clear(); }
+  void commit() {}
+  size_t size() const { return levels.size(); }
+
+  template <class Visitor>
+  void for_each(Visitor&& visitor) const {
+    for (const auto& [price, volume] : levels) {
+      if (!visitor(price, volume))
+        break;
+    }
+  }
+};
+
+// Sorted price and volume arrays with capacity fixed to the subscribed depth.
+// Levels are stored worst first with room on both ends, so the work of an update
+// grows with its distance from the top of the book rather than with the depth:
+// inserts and removals shift only the better levels, the worst level falls off
+// by moving `start`, and snapshots, which come best first, grow towards the front.
+// Running totals of volume and notional from the worst level up answer "how far
+// into the book does this amount reach" with a binary search; the best i levels
+// hold totals[end] - totals[end - i]. A batch of amounts is searched at once on
+// int64 cumulative arrays of the top search_depth levels, which commit() keeps
+// cheap; amounts reaching deeper finish with a branchless search of the totals.
+template <class Better>
+class FlatBookSide {
+  // Below this many levels from the top a linear scan beats the binary search.
+  static constexpr size_t linear_search_limit = 16;
+  static constexpr size_t max_search_depth = 64;
+  static constexpr size_t clean = SIZE_MAX;
+
+  size_t depth;
+  std::vector<Amount> prices;
+  std::vector<Amount> volumes;
+  // Entry j is the volume / notional of the levels below physical index j plus an
+  // arbitrary base, notional is volume * price scaled by Amount::one twice.
+  std::vector<__int128> volume_totals;
+  std::vector<__int128> notional_totals;
+  // Entry i is cumulative volume / notional (rounded down to Amount scale) of the
+  // best i + 1 levels, saturated at INT64_MAX and padded with it to a power of two
+  // past search_depth, as count_not_greater() wants it. For a whole amount a,
+  // notional <= a * one exactly when the rounded down notional <= a, so the search
+  // stays exact.
+  size_t search_depth;
+  std::vector<int64_t> search_volumes;
+  std::vector<int64_t> search_notionals;
+  size_t search_count = 0;
+  // Levels live at physical [start, start + count), the best one last.
+  size_t start = 0;
+  size_t count = 0;
+  // Best first rank of the first search entry that is out of date.
+  size_t dirty_from = clean;
+
+  // Physical end of the levels. Clamped as a reader under a torn seqlock read may
+  // see start and count of different updates.
+  size_t end() const { return std::min(start + count, prices.size()); }
+  size_t first() const { return std::min(start, end()); }
+  // Physical index of the level of best first rank `level`.
+  size_t at(size_t level) const {
+    const size_t e = end();
+    return level < e ? e - 1 - level : 0;
+  }
+
+  // Physical index of the first level better than price, all levels from there
+  // to the end are better.
+  size_t find(Amount price) const {
+    Better better;
+    const size_t e = start + count;
+    // Below the worst level, as all of a snapshot is.
+    if (count == 0 || better(prices[start], price))
+      return start;
+    const size_t linear_end = e - std::min(count, linear_search_limit);
+    size_t j = e;
+    while (j > linear_end && better(prices[j - 1], price))
+      j--;
+    if (j > linear_end || j == start)
+      return j;
+    return std::partition_point(prices.begin() + start, prices.begin() + j,
+                                [&](const Amount& p) { return !better(p, price); }) - prices.begin();
+  }
+
+  static int64_t saturate(__int128 value) {
+    return value >= INT64_MAX ? INT64_MAX : int64_t(value);
+  }
+
+  // saturate(notional / Amount::one) for a non-negative notional, without the
+  // 128-bit division that made commit() slow on deep books. Below saturation the
+  // high word is smaller than one, so long division in 32-bit steps only takes
+  // 64-bit divisions by a constant.
+  static int64_t search_notional(__int128 notional) {
+    static_assert(Amount::one < (__int128(1) << 32));
+    if (notional >= __int128(INT64_MAX) * Amount::one)
+      return INT64_MAX;
+    const uint64_t one = Amount::one;
+    const uint64_t high = uint64_t(notional >> 64);
+    const uint64_t low = uint64_t(notional);
+    uint64_t dividend = (high << 32) | (low >> 32);
+    const uint64_t quotient_high = dividend / one;
+    dividend = ((dividend % one) << 32) | (low & 0xffffffff);
+    return int64_t((quotient_high << 32) | (dividend / one));
+  }
+
+  // Moves the levels to the front of the arrays to make room at the back, and
+  // rebases the totals while at it.
+  void compact() {
+    const __int128 volume_base = volume_totals[start], notional_base = notional_totals[start];
+    std::memmove(&prices[0], &prices[start], count * sizeof(Amount));
+    std::memmove(&volumes[0], &volumes[start], count * sizeof(Amount));
+    for (size_t j = 0; j <= count; j++) {
+      volume_totals[j] = volume_totals[start + j] - volume_base;
+      notional_totals[j] = notional_totals[start + j] - notional_base;
+    }
+    start = 0;
+  }
+  // Levels for the amounts the search arrays found to reach past their top
+  // search_depth levels: the first totals entry not below threshold(i) lies in
+  // [first, end - search_depth], found by a branchless lower bound. Several
+  // amounts go down the search in step, so their loads overlap.
+  template <class Threshold>
+  void search_past_top(const std::vector<__int128>& totals, size_t n, uint32_t* levels, Threshold&& threshold) const {
+    const size_t e = end(), f = first();
+    if (e - f <= search_depth)
+      return;
+    const __int128* const base = totals.data() + f;
+    const size_t length = e - search_depth - f + 1;
+    constexpr size_t lanes = 8;
+    size_t index[lanes];
+    __int128 key[lanes];
+    size_t pos[lanes];
+    for (size_t i = 0; i < n;) {
+      size_t m = 0;
+      for (; i < n && m < lanes; i++) {
+        if (levels[i] >= search_depth) {
+          index[m] = i;
+          key[m++] = threshold(i);
+        }
+      }
+      // Idle lanes search too, fixed lane counts unroll.
+      for (size_t l = 0; l < lanes; l++) {
+        pos[l] = 0;
+        if (l >= m)
+          key[l] = base[0];
+      }
+      for (size_t len = length; len > 1;) {
+        const size_t half = len / 2;
+        for (size_t l = 0; l < lanes; l++)
+          pos[l] += base[pos[l] + half] < key[l] ? half : 0;
+        len -= half;
+      }
+      for (size_t l = 0; l < m; l++)
+        levels[index[l]] = e - f - pos[l] - (base[pos[l]] < key[l]);
+    }
+  }
+public:
+  // One level of room at the back for every four of depth, compaction then costs
+  // about four moves per level that fell off.
+  explicit FlatBookSide(size_t depth) :
+      depth(depth), prices(depth + std::max<size_t>(depth / 4, 4)), volumes(prices.size()),
+      volume_totals(prices.size() + 1), notional_totals(prices.size() + 1),
+      search_depth(std::min(depth, max_search_depth)),
+      search_volumes(std::bit_ceil(search_depth + 1), INT64_MAX),
+      search_notionals(search_volumes.size(), INT64_MAX) {
+    clear();
+  }
+
+  void update(Amount price, Amount volume) {
+    size_t j = find(price);
+    // Levels better than price, i.e. its best first rank.
+    size_t rank = start + count - j;
+    const bool exists = j > start && prices[j - 1] == price;
+    if (rank < search_depth)
+      dirty_from = std::min(dirty_from, rank);
+
+    if (exists) {
+      j--;
+      __int128 volume_change = volume.raw() - volumes[j].raw();
+      if (volume.is_zero()) {
+        // Better levels move down into the gap.
+        const size_t e = start + count;
+        for (size_t t = j + 1; t < e; t++) {
+          prices[t - 1] = prices[t];
+          volumes[t - 1] = volumes[t];
+          volume_totals[t] = volume_totals[t + 1] + volume_change;
+          notional_totals[t] = notional_totals[t + 1] + volume_change * price.raw();
+        }
+        count--;
+        return;
+      }
+      volumes[j] = volume;
+      for (size_t t = j + 1; t <= start + count; t++) {
+        volume_totals[t] += volume_change;
+        notional_totals[t] += volume_change * price.raw();
+      }
+      return;
+    }
+    if (volume.is_zero() || rank >= depth)
+      return;
+
+    // The worst level falls off when the side is full.
+    if (count == depth) {
+      start++;
+      count--;
+    }
+    const __int128 notional = volume.raw() * price.raw();
+    if (rank == count && start > 0) {
+      // New worst level, snapshots fill the side this way.
+      start--;
+      count++;
+      prices[start] = price;
+      volumes[start] = volume;
+      volume_totals[start] = volume_totals[start + 1] - volume.raw();
+      notional_totals[start] = notional_totals[start + 1] - notional;
+      return;
+    }
+    if (start + count == prices.size()) {
+      compact();
+      j = start + count - rank;
+    }
+    // Better levels move up by one.
+    for (size_t t = start + count; t > j; t--) {
+      prices[t] = prices[t - 1];
+      volumes[t] = volumes[t - 1];
+      volume_totals[t + 1] = volume_totals[t] + volume.raw();
+      notional_totals[t + 1] = notional_totals[t] + notional;
+    }
+    prices[j] = price;
+    volumes[j] = volume;
+    volume_totals[j + 1] = volume_totals[j] + volume.raw();
+    notional_totals[j + 1] = notional_totals[j] + notional;
+    count++;
+  }
+
+  // Empty with all the room at the back and the front, whichever way it is filled.
+  void clear() {
+    start = prices.size();
+    count = 0;
+    volume_totals[start] = 0;
+    notional_totals[start] = 0;
+    dirty_from = 0;
+  }
+
+  void commit() {
+    const size_t e = start + count;
+    const size_t levels = std::min(count, search_depth);
+    for (size_t i = dirty_from; i < levels; i++) {
+      search_volumes[i] = saturate(volume_totals[e] - volume_totals[e - 1 - i]);
+      search_notionals[i] = search_notional(notional_totals[e] - notional_totals[e - 1 - i]);
+    }
+    for (size_t i = levels; i < search_count; i++) {
+      search_volumes[i] = INT64_MAX;
+      search_notionals[i] = INT64_MAX;
+    }
+    search_count = levels;
+    dirty_from = clean;
+  }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return depth; }
+  Amount price(size_t level) const { return prices[at(level)]; }
+  Amount cumulative_volume(size_t levels) const {
+    const size_t e = end();
+    return Amount::from_raw(volume_totals[e] - volume_totals[e - std::min(levels, e - first())]);
+  }
+  __int128 cumulative_notional(size_t levels) const {
+    const size_t e = end();
+    return notional_totals[e] - notional_totals[e - std::min(levels, e - first())];
+  }
+
+  // Number of best levels whose cumulative volume fits into `volume`.
+  size_t levels_within_volume(Amount volume) const {
+    const size_t e = end();
+    const __int128 threshold = volume_totals[e] - volume.raw();
+    const size_t j = std::lower_bound(volume_totals.begin() + first(), volume_totals.begin() + e + 1, threshold) -
+                     volume_totals.begin();
+    return j > e ? 0 : e - j;
+  }
+
+  // Number of best levels whose cumulative notional fits into `notional`.
+  size_t levels_within_notional(__int128 notional) const {
+    const size_t e = end();
+    const __int128 threshold = notional_totals[e] - notional;
+    const size_t j = std::lower_bound(notional_totals.begin() + first(), notional_totals.begin() + e + 1, threshold) -
+                     notional_totals.begin();
+    return j > e ? 0 : e - j;
+  }
+
+  // Batch levels_within_volume for raw volumes below INT64_MAX. Under a torn
+  // seqlock read the counts may exceed size(), callers clamp them.
+  void levels_within_volumes(const int64_t* raw_volumes, size_t n, uint32_t* levels) const {
+    count_not_greater(search_volumes.data(), search_volumes.size(), raw_volumes, n, levels);
+    const __int128 total = volume_totals[end()];
+    search_past_top(volume_totals, n, levels, [&](size_t i) { return total - raw_volumes[i]; });
+  }
+
+  // Batch levels_within_notional for notionals raw_amounts[i] * Amount::one.
+  void levels_within_notionals(const int64_t* raw_amounts, size_t n, uint32_t* levels) const {
+    count_not_greater(search_notionals.data(), search_notionals.size(), raw_amounts, n, levels);
+    const __int128 total = notional_totals[end()];
+    search_past_top(notional_totals, n, levels, [&](size_t i) { return total - __int128(raw_amounts[i]) * Amount::one; });
+  }
+
+  template <class Visitor>
+  void for_each(Visitor&& visitor) const {
+    for (size_t j = end(); j > first(); j--) {
+      if (!visitor(prices[j - 1], volumes[j - 1]))
+        break;
+    }
+  }
+};
@@ -0,0 +1,8 @@
+#include <cstddef>
+#include <cstdint>
+
+#pragma once
+
+// CRC-32 (IEEE 802.3, as in zlib) using slice-by-8 tables. Chains like zlib's
+// crc32(): pass the previous result to continue a running checksum.
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
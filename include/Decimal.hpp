@@ -0,0 +1,141 @@
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#pragma once
+
+namespace decimal_detail {
+
+constexpr __int128 pow10(unsigned exponent) {
+  __int128 rv = 1;
+  while (exponent-- > 0)
+    rv *= 10;
+  return rv;
+}
+
+// num / den rounded to nearest, ties away from zero. den must be positive.
+constexpr __int128 div_round(__int128 num, __int128 den) {
+  __int128 quotient = num / den;
+  __int128 remainder = num % den;
+  __int128 twice = remainder < 0 ? -2 * remainder : 2 * remainder;
+  if (twice >= den)
+    quotient += num < 0 ? -1 : 1;
+  return quotient;
+}
+} //namespace decimal_detail
+
+// Fixed-point number with Scale decimal digits kept in a 128 bit integer.
+// Parsing and formatting are exact; mul/div round once, to nearest.
+template <unsigned Scale>
+class Decimal {
+  __int128 _raw;
+
+  constexpr explicit Decimal(__int128 raw) : _raw(raw) {}
+public:
+  static constexpr unsigned scale = Scale;
+  static constexpr __int128 one = decimal_detail::pow10(Scale);
+
+  constexpr Decimal() : _raw(0) {}
+
+  static constexpr Decimal from_raw(__int128 raw) { return Decimal(raw); }
+  static constexpr Decimal from_integer(int64_t value) { return Decimal(value * one); }
+  // Product of two raw values (scaled by one^2) rounded back to Scale digits.
+  static constexpr Decimal from_product(__int128 product) { return Decimal(decimal_detail::div_round(product, one)); }
+
+  // Parses "[-]digits[.digits]". Digits past Scale are rounded half up. Returns
+  // false on anything else, out is left untouched in that case.
+  static constexpr bool parse(std::string_view s, Decimal& out) {
+    const char* p = s.data();
+    const char* end = p + s.size();
+    bool negative = p != end && *p == '-';
+    if (negative)
+      ++p;
+
+    __int128 value = 0;
+    bool any_digit = false;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      value = value * 10 + (*p - '0');
+      any_digit = true;
+    }
+
+    unsigned fraction_digits = 0;
+    if (p != end && *p == '.') {
+      ++p;
+      for (; p != end && *p >= '0' && *p <= '9' && fraction_digits < Scale; ++p, ++fraction_digits) {
+        value = value * 10 + (*p - '0');
+        any_digit = true;
+      }
+      if (p != end && *p >= '5' && *p <= '9')
+        value++;
+      while (p != end && *p >= '0' && *p <= '9')
+        ++p;
+    }
+    if (p != end || !any_digit)
+      return false;
+
+    value *= decimal_detail::pow10(Scale - fraction_digits);
+    out = Decimal(negative ? -value : value);
+    return true;
+  }
+
+  // Like parse(), but malformed input yields zero.
+  static constexpr Decimal from_string(std::string_view s) {
+    Decimal rv;
+    parse(s, rv);
+    return rv;
+  }
+
+  constexpr __int128 raw() const { return _raw; }
+  constexpr bool is_zero() const { return _raw == 0; }
+
+  constexpr Decimal mul(Decimal other) const { return from_product(_raw * other._raw); }
+  constexpr Decimal div(Decimal other) const { return Decimal(decimal_detail::div_round(_raw * one, other._raw)); }
+  // this * multiplier / divisor with a single rounding step.
+  constexpr Decimal mul_div(Decimal multiplier, Decimal divisor) const {
+    return Decimal(decimal_detail::div_round(_raw * multiplier._raw, divisor._raw));
+  }
+
+  // Cut to `digits` decimal places, toward zero.
+  constexpr Decimal truncated(unsigned digits) const {
+    if (digits >= Scale)
+      return *this;
+    const __int128 unit = decimal_detail::pow10(Scale - digits);
+    return Decimal(_raw / unit * unit);
+  }
+
+  constexpr Decimal operator+(Decimal other) const { return Decimal(_raw + other._raw); }
+  constexpr Decimal operator-(Decimal other) const { return Decimal(_raw - other._raw); }
+  constexpr Decimal operator-() const { return Decimal(-_raw); }
+  constexpr Decimal& operator+=(Decimal other) { _raw += other._raw; return *this; }
+  constexpr Decimal& operator-=(Decimal other) { _raw -= other._raw; return *this; }
+
+  constexpr auto operator<=>(const Decimal& other) const = default;
+  constexpr bool operator==(const Decimal& other) const = default;
+
+  // Formats with exactly `digits` decimal places, rounding when digits < Scale.
+  std::string to_string(unsigned digits = Scale) const {
+    __int128 value = _raw;
+    if (digits < Scale)
+      value = decimal_detail::div_round(value, decimal_detail::pow10(Scale - digits));
+    unsigned __int128 tmp = value < 0 ? -value : value;
+
+    char buffer[64];
+    char* d = buffer + sizeof(buffer);
+    for (unsigned i = Scale; i < digits; i++)
+      *--d = '0';
+    for (unsigned i = 0; i < (digits < Scale ? digits : Scale); i++) {
+      *--d = char('0' + tmp % 10);
+      tmp /= 10;
+    }
+    if (digits > 0)
+      *--d = '.';
+    do {
+      *--d = char('0' + tmp % 10);
+      tmp /= 10;
+    } while (tmp != 0);
+    if (value < 0)
+      *--d = '-';
+    return std::string(d, buffer + sizeof(buffer) - d);
+  }
+};
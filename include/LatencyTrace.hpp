@@ -0,0 +1,124 @@
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#pragma once
+
+// Tick-to-trade tracing, built with -DBOOKER_LATENCY_TRACE (CMake option of the
+// same name). Without it trace_now() is a constant 0 and trace_span() empty, so
+// the instrumentation compiles away.
+#ifdef BOOKER_LATENCY_TRACE
+inline constexpr bool latency_trace_enabled = true;
+#else
+inline constexpr bool latency_trace_enabled = false;
+#endif
+
+enum class TraceSpan : uint8_t {
+  Parse,           // frame received -> parsed
+  Apply,           // parsed -> book updated
+  Detect,          // book updated -> opportunity detected (strategy thread)
+  TickToDetect,    // frame received -> opportunity detected
+  OrderQueue,      // send_trade_async -> order on the wire
+  OrderRoundTrip,  // order on the wire -> response received
+  TickToTrade,     // frame received -> order on the wire
+  Count
+};
+
+const char* trace_span_name(TraceSpan span);
+
+// Log-linear histogram of nanosecond values after HdrHistogram: values below 64
+// are exact, above that every power of two is split into 32 buckets, so a value
+// is reported at most ~3% high. Any thread may record, a record is two relaxed
+// atomic operations.
+class LatencyHistogram {
+public:
+  static constexpr unsigned sub_bucket_bits = 6;
+  static constexpr uint64_t sub_buckets = 1 << sub_bucket_bits;
+  static constexpr uint64_t half_buckets = sub_buckets / 2;
+  // Values from 2^41 ns (~37 minutes) on land in the last bucket.
+  static constexpr unsigned max_bits = 41;
+  static constexpr size_t bucket_count = sub_buckets + (max_bits - sub_bucket_bits) * half_buckets;
+
+  struct Summary {
+    uint64_t count = 0;
+    double mean = 0;
+    uint64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+  };
+
+  void record(uint64_t value) {
+    counts[index(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed));
+  }
+  // Summarises what was recorded since the last call and starts over.
+  Summary take();
+
+  static size_t index(uint64_t value) {
+    if (value < sub_buckets)
+      return value;
+    const unsigned shift = std::bit_width(value) - sub_bucket_bits;
+    const size_t i = sub_buckets + (shift - 1) * half_buckets + ((value >> shift) - half_buckets);
+    return i < bucket_count ? i : bucket_count - 1;
+  }
+  // Highest value that falls into bucket i.
+  static uint64_t highest_value(size_t i) {
+    if (i < sub_buckets)
+      return i;
+    const unsigned shift = (i - sub_buckets) / half_buckets + 1;
+    const uint64_t sub = (i - sub_buckets) % half_buckets + half_buckets;
+    return ((sub + 1) << shift) - 1;
+  }
+private:
+  std::array<std::atomic<uint64_t>, bucket_count> counts{};
+  std::atomic<uint64_t> sum{0};
+  std::atomic<uint64_t> max{0};
+};
+
+namespace latency_detail {
+extern std::array<LatencyHistogram, static_cast<size_t>(TraceSpan::Count)> histograms;
+// TSC ticks to ns as a 32.32 fixed point factor, zero when the TSC is not usable.
+extern uint64_t tsc_to_ns;
+}
+
+// Receive time of the frame behind the decision being made on this thread, set
+// by the strategy when it detects an opportunity and picked up by the orders it
+// sends.
+inline thread_local uint64_t trace_trigger_ns = 0;
+
+// Monotonic nanoseconds from the invariant TSC where there is one, else
+// steady_clock. Only differences between two values mean anything.
+inline uint64_t trace_now() {
+  if constexpr (!latency_trace_enabled) {
+    return 0;
+  } else {
+#if defined(__x86_64__)
+    if (latency_detail::tsc_to_ns != 0)
+      return static_cast<uint64_t>((static_cast<unsigned __int128>(__rdtsc()) * latency_detail::tsc_to_ns) >> 32);
+#endif
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+}
+
+// Records end - start into the span's histogram, nothing when start is unknown.
+inline void trace_span(TraceSpan span, uint64_t start, uint64_t end) {
+  if constexpr (latency_trace_enabled) {
+    if (start != 0 && end >= start)
+      latency_detail::histograms[static_cast<size_t>(span)].record(end - start);
+  }
+}
+
+// take() of every span that has samples.
+std::vector<std::pair<TraceSpan, LatencyHistogram::Summary>> take_latency_summaries();
+std::string format_latency_summary(TraceSpan span, const LatencyHistogram::Summary& summary);
+// Logs the summaries every interval and appends them to path as JSON lines.
+void start_latency_reports(std::chrono::seconds interval, const std::string& path);
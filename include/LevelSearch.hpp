@@ -0,0 +1,23 @@
+#include <cstddef>
+#include <cstdint>
+
+#pragma once
+
+// Instruction sets count_not_greater() can run on, picked at runtime.
+enum class SearchIsa { Scalar, Avx2, Avx512 };
+
+// counts[i] = number of entries of `sorted` not greater than keys[i], for n keys.
+// `sorted` holds `padded` entries, a power of two, filled up with INT64_MAX so that
+// at least the last entry is padding; keys must be below INT64_MAX. The search is
+// a branchless binary search, the SIMD kernels replace its last steps with
+// compares over a contiguous window, 4 (AVX2) or 8 (AVX-512) entries at a time.
+using CountKernel = void (*)(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts);
+
+void count_not_greater(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts);
+
+// Widest instruction set supported by this CPU.
+SearchIsa best_search_isa();
+// Makes count_not_greater() use `isa`, returns false when the CPU lacks it.
+bool use_search_isa(SearchIsa isa);
+SearchIsa active_search_isa();
+const char* search_isa_name(SearchIsa isa);
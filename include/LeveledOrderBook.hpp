@@ -1,39 +1,156 @@
 #include "OrderBook.hpp"
+#include "BookLevels.hpp"
+#include "SeqLock.hpp"
+#include <atomic>
 #include <map>
 #include <mutex>
+#include <span>
 #pragma once
 
 class KrakenExchange;
 
+static const size_t default_book_depth = 10;
+// Kraken's book checksum covers this many levels per side.
+static const size_t checksum_depth = 10;
+
+// One linear piece of a conversion curve: up to `capacity` of input converts at `rate`.
+struct ConversionSegment {
+  double rate;
+  Amount capacity;
+};
+
+struct LevelUpdate {
+  BookSide side;
+  Amount price;
+  Amount volume;
+};
+
+// Levels are written by a single thread (the exchange ingest thread). With flat
+// storage readers never block it: they read under a seqlock and retry when an
+// update overlapped. Map storage can't be read optimistically and keeps the mutex.
 class LeveledOrderBook : public GenericOrderBook {
 protected:
-  std::map<__int128, __int128> bids;
-  std::map<__int128, __int128> asks;
+  const BookStorage storage;
+  MapBookSide<std::greater<Amount>> map_bids;
+  MapBookSide<std::less<Amount>> map_asks;
+  FlatBookSide<std::greater<Amount>> flat_bids;
+  FlatBookSide<std::less<Amount>> flat_asks;
   const Symbol& symbol1, &symbol2;
+  const unsigned pair_decimals, lot_decimals;
   mutable std::mutex update_mutex;
+  SeqLock levels_lock;
+  std::atomic<uint64_t> generation{0};
+  mutable std::atomic<bool> change_queued{false};
+  std::atomic<bool> valid{false};
+  std::atomic<bool> stale{false};
+  std::atomic<bool> checksum_enabled{true};
+  // trace_now() when the last applied frame was received and when it was in the
+  // book, zero unless built with BOOKER_LATENCY_TRACE.
+  std::atomic<uint64_t> trace_received_ns{0};
+  std::atomic<uint64_t> trace_updated_ns{0};
+  // Index of the feed shard applying frames to this book, see KrakenFeedShard.
+  std::atomic<uint32_t> writer{0};
+
+  // Calls reader(asks, bids) on a consistent view of the selected storage.
+  template <class Reader>
+  auto read_sides(Reader&& reader) const {
+    if (storage == BookStorage::Flat) {
+      decltype(reader(flat_asks, flat_bids)) rv;
+      uint64_t version;
+      do {
+        version = levels_lock.read_begin();
+        rv = reader(flat_asks, flat_bids);
+      } while (levels_lock.read_retry(version));
+      return rv;
+    }
+    const std::lock_guard<std::mutex> lock(update_mutex);
+    return reader(map_asks, map_bids);
+  }
+
+  // Calls writer(asks, bids) on the selected storage, publishing the change to
+  // readers as a whole and bumping the generation.
+  template <class Writer>
+  void write_sides(Writer&& writer) {
+    if (storage == BookStorage::Flat) {
+      levels_lock.write_begin();
+      writer(flat_asks, flat_bids);
+      flat_asks.commit();
+      flat_bids.commit();
+      levels_lock.write_end();
+    } else {
+      const std::lock_guard<std::mutex> lock(update_mutex);
+      writer(map_asks, map_bids);
+    }
+    generation.fetch_add(1, std::memory_order_release);
+  }
 public:
-  LeveledOrderBook(const Symbol& s1, const Symbol& s2);
+  LeveledOrderBook(const Symbol& s1, const Symbol& s2, unsigned pair_decimals = decimals, unsigned lot_decimals = decimals,
+                   size_t depth = default_book_depth, BookStorage storage = BookStorage::Flat);
   LeveledOrderBook(LeveledOrderBook&& other);
   LeveledOrderBook(const LeveledOrderBook&) = delete;
   //LeveledOrderBook& operator=(const LeveledOrderBook& other);
 
   const Symbol& get_symbol_1() const override;
   const Symbol& get_symbol_2() const override;
+  unsigned get_pair_decimals() const;
+  unsigned get_lot_decimals() const;
+  BookStorage get_storage() const;
+  // Increases with every applied frame, unchanged generation means unchanged book.
+  uint64_t get_generation() const;
+  // A book is valid from its first snapshot until invalidate(). Estimates of an
+  // invalid book are zero, so strategies never trade on it.
+  bool is_valid() const;
+  // A book restored from the warm-start cache is valid but stale until its first
+  // live snapshot: good for pricing, not for trading.
+  bool is_stale() const;
+  uint64_t get_trace_received_ns() const;
+  uint64_t get_trace_updated_ns() const;
+  // Kraken CRC32 over the top checksum_depth asks and bids. Only meaningful when
+  // supports_checksum(), i.e. the pair's decimals fit into Amount.
+  uint32_t checksum() const;
+  bool supports_checksum() const;
 
   __int128 estimate_conversion_from_1(__int128 amount) const override;
   __int128 estimate_conversion_from_2(__int128 amount) const override;
+  __int128 estimate_required_from_1(__int128 target) const override;
+  __int128 estimate_required_from_2(__int128 target) const override;
 
   __int128 estimate_fee_from_1(__int128 amount) const override;
   __int128 estimate_fee_from_2(__int128 amount) const override;
 
-  
+  // Non-virtual forms of the estimates above for statically dispatched callers:
+  // `reversed` selects the from_2 direction, as a ReverseOrderBook would.
+  Amount convert(Amount amount, bool reversed) const;
+  Amount required(Amount target, bool reversed) const;
+  Amount fee(Amount amount, bool) const { return Amount::from_raw(amount.raw() * 24 / 10000); }
+
+  // out[i] = estimate_conversion_from_1/2(amounts[i]) with a single read of the
+  // book; flat storage searches the levels for many amounts at once with SIMD.
+  void estimate_conversions_from_1(std::span<const Amount> amounts, std::span<Amount> out) const;
+  void estimate_conversions_from_2(std::span<const Amount> amounts, std::span<Amount> out) const;
+
+  // Replaces `segments` with the piecewise linear curve of estimate_conversion_from_1
+  // (from_2 when from_symbol_2), best rate first and before fees.
+  void get_conversion_curve(bool from_symbol_2, std::vector<ConversionSegment>& segments) const;
+
 
   void update() override;
 
+  // Appends the asks, then the bids of a consistent view. False for an invalid book.
+  bool get_levels(std::vector<LevelUpdate>& levels) const;
+
   std::string print() const override;
 protected:
-  void updateAskLevel(__int128 price, __int128 volume);
-  void updateBidLevel(__int128 price, __int128 volume);
+  // Applies all level changes of one frame atomically, a snapshot replaces the book.
+  void apply_updates(std::span<const LevelUpdate> updates, bool snapshot);
+  void updateAskLevel(Amount price, Amount volume);
+  void updateBidLevel(Amount price, Amount volume);
+  void invalidate();
+  // Loads cached levels into the book and marks it valid but stale.
+  void restore(std::span<const LevelUpdate> levels);
+  // For a pair whose live decimals no longer match the ones this book was built
+  // with, checksums would be formatted wrongly and never match.
+  void disable_checksum();
   friend class KrakenExchange;
+  friend class BookChangeQueue;
 };
-
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <string>
 #include <vector>
 #include <map>
@@ -6,6 +7,9 @@
 #include "Symbol.hpp"
 #pragma once
 
+enum class BookSide : uint8_t { Ask, Bid };
+
+class TradingGraph;
 
 class GenericOrderBook {
 public:
@@ -15,6 +19,10 @@ public:
 
   virtual __int128 estimate_conversion_from_1(__int128 amount) const = 0;
   virtual __int128 estimate_conversion_from_2(__int128 amount) const = 0;
+  // Inverse of the above: how much of symbol1 (resp. symbol2) has to be converted
+  // to receive `target` of the other symbol. Negative when the book is too thin.
+  virtual __int128 estimate_required_from_1(__int128 target) const = 0;
+  virtual __int128 estimate_required_from_2(__int128 target) const = 0;
 
   virtual __int128 estimate_fee_from_1(__int128 amount) const = 0;
   virtual __int128 estimate_fee_from_2(__int128 amount) const = 0;
@@ -34,6 +42,8 @@ public:
   const Symbol& get_symbol_2() const override;
   __int128 estimate_conversion_from_1(__int128 amount) const override;
   __int128 estimate_conversion_from_2(__int128 amount) const override;
+  __int128 estimate_required_from_1(__int128 target) const override;
+  __int128 estimate_required_from_2(__int128 target) const override;
   __int128 estimate_fee_from_1(__int128 amount) const override;
   __int128 estimate_fee_from_2(__int128 amount) const override;
   void update() override;
@@ -50,6 +60,8 @@ public:
   const Symbol& get_symbol_2() const override;
   __int128 estimate_conversion_from_1(__int128 amount) const override;
   __int128 estimate_conversion_from_2(__int128 amount) const override;
+  __int128 estimate_required_from_1(__int128 target) const override;
+  __int128 estimate_required_from_2(__int128 target) const override;
   __int128 estimate_fee_from_1(__int128 amount) const override;
   __int128 estimate_fee_from_2(__int128 amount) const override;
   void update() override;
@@ -62,4 +74,9 @@ public:
   virtual std::vector<std::reference_wrapper<const Symbol>> get_all_symbols() = 0;
   virtual std::map<std::reference_wrapper<const Symbol>, std::set<std::reference_wrapper<const Symbol>>> get_trading_pairs() = 0;
   virtual bool has_trading_pair(const Symbol& symbol1, const Symbol& symbol2) = 0;
+  // Built once when the pairs are loaded, cheap to walk and never reallocated by lookups.
+  virtual const TradingGraph& get_trading_graph() = 0;
+  // Blocks until some books changed (true) or the timeout expired (false), `changed`
+  // receives the books updated since the previous call.
+  virtual bool wait_for_changes(std::vector<const GenericOrderBook*>& changed, std::chrono::milliseconds timeout) = 0;
 };
\ No newline at end of file
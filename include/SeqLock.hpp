@@ -0,0 +1,49 @@
+#include <atomic>
+#include <cstdint>
+
+#pragma once
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Sequence lock for a single writer and any number of readers. The writer never
+// waits; readers take a snapshot of the version, read optimistically and retry
+// when a write overlapped their read:
+//
+//   uint64_t version;
+//   do {
+//     version = lock.read_begin();
+//     ... read ...
+//   } while (lock.read_retry(version));
+//
+// Data read inside the loop may be torn, so readers must not trust it (e.g. divide
+// by it) before read_retry() confirmed it.
+class SeqLock {
+  std::atomic<uint64_t> sequence{0};
+public:
+  void write_begin() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void write_end() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  uint64_t read_begin() const {
+    uint64_t version;
+    while ((version = sequence.load(std::memory_order_acquire)) & 1)
+      cpu_relax();
+    return version;
+  }
+
+  bool read_retry(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) != version;
+  }
+};
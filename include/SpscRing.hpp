@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#pragma once
+
+// Single producer, single consumer ring of variable sized records, each stored
+// as a u32 length followed by the bytes and wrapping around the end of the
+// buffer. The producer never blocks or allocates: a record that does not fit is
+// dropped and counted. Head and tail are free-running byte counters.
+class SpscRing {
+  std::vector<char> buffer;
+  const size_t mask;
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t tail_cache = 0;  // producer's view of tail
+  alignas(64) std::atomic<uint64_t> tail{0};
+  alignas(64) std::atomic<uint64_t> dropped_records{0};
+
+  void copy_in(uint64_t pos, const void* data, size_t size) {
+    size_t offset = pos & mask;
+    size_t first = std::min(size, buffer.size() - offset);
+    std::memcpy(buffer.data() + offset, data, first);
+    std::memcpy(buffer.data(), static_cast<const char*>(data) + first, size - first);
+  }
+  void copy_out(uint64_t pos, void* data, size_t size) const {
+    size_t offset = pos & mask;
+    size_t first = std::min(size, buffer.size() - offset);
+    std::memcpy(data, buffer.data() + offset, first);
+    std::memcpy(static_cast<char*>(data) + first, buffer.data(), size - first);
+  }
+public:
+  // Capacity is rounded up to a power of two.
+  explicit SpscRing(size_t capacity) :
+      buffer(std::bit_ceil(std::max<size_t>(capacity, 64))), mask(buffer.size() - 1) {}
+
+  // Producer: appends one record made of the concatenated parts.
+  bool push(std::initializer_list<std::span<const char>> parts) {
+    uint32_t size = 0;
+    for (const auto& part : parts)
+      size += part.size();
+    const uint64_t h = head.load(std::memory_order_relaxed);
+    const uint64_t needed = sizeof(size) + size;
+    if (h + needed - tail_cache > buffer.size()) {
+      tail_cache = tail.load(std::memory_order_acquire);
+      if (h + needed - tail_cache > buffer.size()) {
+        dropped_records.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    copy_in(h, &size, sizeof(size));
+    uint64_t pos = h + sizeof(size);
+    for (const auto& part : parts) {
+      copy_in(pos, part.data(), part.size());
+      pos += part.size();
+    }
+    head.store(pos, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: calls visitor(std::span<const char>) for every record available,
+  // returns how many. A record that wraps is copied into `scratch` first.
+  template <class Visitor>
+  size_t consume(std::vector<char>& scratch, Visitor&& visitor) {
+    const uint64_t h = head.load(std::memory_order_acquire);
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    size_t records = 0;
+    while (t != h) {
+      uint32_t size;
+      copy_out(t, &size, sizeof(size));
+      t += sizeof(size);
+      size_t offset = t & mask;
+      if (offset + size <= buffer.size()) {
+        visitor(std::span<const char>(buffer.data() + offset, size));
+      } else {
+        scratch.resize(size);
+        copy_out(t, scratch.data(), size);
+        visitor(std::span<const char>(scratch.data(), size));
+      }
+      t += size;
+      records++;
+    }
+    tail.store(t, std::memory_order_release);
+    return records;
+  }
+
+  uint64_t dropped() const { return dropped_records.load(std::memory_order_relaxed); }
+};
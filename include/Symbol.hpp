@@ -6,16 +6,19 @@
 
 #include <iostream>
 #include <map>
+#include <vector>
+#include "constants.hpp"
 
 class Symbol {
 private:
   std::string _name;
   std::string _symbol;
   std::string _exchange;
-  mutable __int128 _reference_rate_estimate;
+  size_t _id;
+  mutable Amount _reference_rate_estimate;
 protected:
-  Symbol(const std::string& symbol, const std::string& name, const std::string& exchange);
-  Symbol(const std::string& symbol, const std::string& exchange);
+  Symbol(size_t id, const std::string& symbol, const std::string& name, const std::string& exchange);
+  Symbol(size_t id, const std::string& symbol, const std::string& exchange);
 public:
   Symbol(Symbol&& other);
   Symbol(const Symbol& other) = delete;
@@ -24,8 +27,10 @@ public:
   const std::string& get_symbol() const;
   const std::string& get_name() const;
   const std::string& get_exchange() const;
-  __int128 get_reference_rate_estimate() const;
-  void set_reference_rate_estimate(__int128 reference_rate_estimate) const;
+  // Dense index assigned by SymbolFactory, usable to index flat tables.
+  size_t get_id() const;
+  Amount get_reference_rate_estimate() const;
+  void set_reference_rate_estimate(Amount reference_rate_estimate) const;
   friend bool operator<(const Symbol& first, const Symbol& second);
   friend bool operator==(const Symbol& first, const Symbol& second);
 
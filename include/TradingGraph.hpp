@@ -0,0 +1,42 @@
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "TradingPairTable.hpp"
+
+#pragma once
+
+// Immutable trading graph in compressed sparse row form. Nodes are symbols, the
+// edge a -> b carries the handle of the book converting a into b. Edges of a node
+// are contiguous and sorted by target node, so walking the graph is a scan over
+// two arrays.
+class TradingGraph {
+public:
+  struct Edge {
+    uint32_t target;
+    BookHandle handle;
+  };
+  static constexpr uint32_t no_node = UINT32_MAX;
+private:
+  std::vector<std::reference_wrapper<const Symbol>> nodes;
+  std::vector<uint32_t> node_by_symbol_id;
+  std::vector<uint32_t> offsets;
+  std::vector<Edge> edges;
+public:
+  TradingGraph() = default;
+  // One edge per handle, from its generic book's symbol 1 to symbol 2.
+  explicit TradingGraph(std::span<const BookHandle> handles);
+
+  size_t node_count() const { return nodes.size(); }
+  size_t edge_count() const { return edges.size(); }
+  const Symbol& symbol(uint32_t node) const { return nodes[node]; }
+
+  uint32_t node_of(const Symbol& symbol) const {
+    size_t id = symbol.get_id();
+    return id < node_by_symbol_id.size() ? node_by_symbol_id[id] : no_node;
+  }
+
+  std::span<const Edge> edges_from(uint32_t node) const {
+    return std::span<const Edge>(edges.data() + offsets[node], offsets[node + 1] - offsets[node]);
+  }
+};
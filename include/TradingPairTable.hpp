@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "LeveledOrderBook.hpp"
+
+#pragma once
+
+// An order book seen from one direction of its pair. `generic` is the book itself
+// for the listed direction and its ReverseOrderBook for the opposite one.
+// Strategy code prices through the methods below, which call LeveledOrderBook
+// directly with the direction bit instead of two virtual hops through `generic`;
+// `generic` stays for symbols, printing and tooling.
+struct BookHandle {
+  const LeveledOrderBook* book = nullptr;
+  bool reversed = false;
+  const GenericOrderBook* generic = nullptr;
+
+  // estimate_conversion_from_1 / estimate_required_from_1 / estimate_fee_from_1 of `generic`.
+  Amount convert(Amount amount) const { return book->convert(amount, reversed); }
+  Amount required(Amount target) const { return book->required(target, reversed); }
+  Amount fee(Amount amount) const { return book->fee(amount, reversed); }
+};
+
+// out[i] = books[i].convert(amount) for a batch of handles.
+void estimate_conversions(std::span<const BookHandle> books, Amount amount, std::span<Amount> out);
+
+// (symbol id, symbol id) -> BookHandle as a flat N x N table over the dense ids
+// handed out by SymbolFactory. Cells are 32 bit slots into the handle array,
+// so a lookup is two loads and the table stays small for ~700 pairs.
+class TradingPairTable {
+  size_t symbol_count = 0;
+  std::vector<uint32_t> slots;
+  std::vector<BookHandle> handles;
+  static constexpr uint32_t no_slot = UINT32_MAX;
+public:
+  // Sizes the table for symbol ids below symbol_count and forgets all pairs.
+  void reset(size_t symbol_count);
+  // Registers book as (s1, s2) and its reverse as (s2, s1).
+  void add(const LeveledOrderBook& book, const ReverseOrderBook& reverse);
+
+  const BookHandle* find(const Symbol& symbol1, const Symbol& symbol2) const {
+    size_t id1 = symbol1.get_id(), id2 = symbol2.get_id();
+    if (id1 >= symbol_count || id2 >= symbol_count)
+      return nullptr;
+    uint32_t slot = slots[id1 * symbol_count + id2];
+    return slot == no_slot ? nullptr : &handles[slot];
+  }
+
+  size_t size() const { return handles.size() / 2; }
+  // Both directions of every registered pair.
+  std::span<const BookHandle> get_handles() const { return handles; }
+};
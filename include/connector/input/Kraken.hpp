@@ -1,39 +1,169 @@
+#include <atomic>
+#include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <Poco/JSON/Object.h>
 #include "LeveledOrderBook.hpp"
+#include "BookChangeQueue.hpp"
+#include "TradingPairTable.hpp"
+#include "TradingGraph.hpp"
+#include "connector/input/KrakenBookParser.hpp"
+#include "connector/input/KrakenFeedShard.hpp"
+#include "connector/input/KrakenWarmCache.hpp"
+#include "connector/input/MarketRecorder.hpp"
+#include "connector/trade/HttpsSessionPool.hpp"
+#include "connector/trade/KrakenWsTrading.hpp"
+#include "connector/trade/NonceGenerator.hpp"
+#include "connector/trade/Orders.hpp"
+#include "connector/trade/RequestWorkers.hpp"
+#include "LatencyTrace.hpp"
 #include "OrderBook.hpp"
 #include "Utils.hpp"
 
 static const char *const https_host = "api.kraken.com";
 static const char *const ws_host = "ws.kraken.com";
 static const char *const http_buy_endpoint = "/0/private/AddOrder";
+static const char *const ws_token_endpoint = "/0/private/GetWebSocketsToken";
 static const char *const ws_endpoint = "/ws";
 
 #pragma once
 
+namespace Poco::Net {
+class WebSocket;
+}
+
 class KrakenExchange : public GenericOrderBookCollection {
   std::set<std::reference_wrapper<const Symbol>> all_symbols;
-  std::map<std::string, LeveledOrderBook> trading_pairs;
+  std::map<std::string, LeveledOrderBook, std::less<>> trading_pairs;
   std::map<std::string, ReverseOrderBook> reverse_order_books;
   std::map<std::pair<std::string, std::string>, std::string> trading_pair_resolver;
+  // wsname -> AssetPairs key, which is what the REST endpoints take.
+  std::map<std::string, std::string> rest_pair_names;
+  TradingPairTable pair_table;
+  TradingGraph trading_graph;
   static NullOrderBook null_book;
+  BookChangeQueue book_changes;
+  std::vector<const LeveledOrderBook*> changed_books;
+  // Kraken.FeedShards book feed connections, the pairs are split between them.
+  // Offline there is one, used by replay().
+  std::vector<std::unique_ptr<KrakenFeedShard>> shards;
+  // Kraken.FeedRebalanceInterval, zero keeps the initial split.
+  std::chrono::seconds rebalance_interval;
+  // Set by Kraken.Record, captures the feed as received.
+  std::unique_ptr<MarketRecorder> recorder;
+  // The recorder ring takes one producer at a time.
+  std::mutex recorder_mutex;
 
-  void process_ws();
-  void fetch_trading_pairs();
-  uint64_t try_fetch_reference_rate(const std::string& pair_name);
+  void process_ws(KrakenFeedShard& shard);
+  // What process_ws does with one received text frame, true for a book frame.
+  bool handle_frame(KrakenFeedShard& shard, const char* data, size_t size, KrakenBookFrame& frame);
+  void apply_book_frame(KrakenFeedShard& shard, const KrakenBookFrame& frame);
+  // Columnar recordings hold the decoded levels, applied like apply_book_frame.
+  void apply_recorded_frame(KrakenFeedShard& shard, const RecordedFrame& frame);
+  // Stamps the book with the frame's trace times for the strategy to pick up.
+  void trace_book_update(KrakenFeedShard& shard, LeveledOrderBook& ob);
+  void send_resyncs(KrakenFeedShard& shard, Poco::Net::WebSocket& ws);
+  void invalidate_shard_books(const KrakenFeedShard& shard);
+  // Round robin over the pairs, before the feed connects.
+  void assign_pairs_to_shards();
+  // Runs the releases and acquisitions posted to the shard on its thread. Without
+  // a connection the subscriptions are left to the next connect.
+  void process_handovers(KrakenFeedShard& shard, Poco::Net::WebSocket* ws);
+  // Moves pairs from busy shards to idle ones by their frames per interval.
+  void rebalance_shards_periodically();
+  void rebuild_pair_index();
+  std::vector<KrakenPairInfo> fetch_asset_pairs();
+  std::vector<KrakenPairInfo> parse_asset_pairs(Poco::JSON::Object::Ptr object);
+  void add_trading_pairs(const std::vector<KrakenPairInfo>& pairs);
+  // Pairs the books were built from, in AssetPairs order.
+  std::vector<KrakenPairInfo> pair_infos;
+  // Sets every symbol's USD reference rate from bulk Ticker requests over its USD pair.
+  void fetch_reference_rates();
   Poco::Logger& logger;
 
+  // Kraken.WarmCache: empty disables the warm start.
+  std::string warm_cache_path;
+  std::chrono::seconds warm_cache_interval;
+  std::chrono::seconds warm_cache_max_age;
+  // Builds pairs, symbols, rates and stale books from the cache, false if there is
+  // no usable one.
+  bool load_warm_cache();
+  // Compares the live AssetPairs with the cached ones the books were built from.
+  void validate_trading_pairs(const std::vector<KrakenPairInfo>& live);
+  void save_warm_cache();
+  void save_warm_cache_periodically();
+
   std::string APIKey;
   std::string PrivateKey;
+  size_t book_depth;
+  BookStorage book_storage;
+  // Warm keep-alive sessions to https_host for all REST calls.
+  std::unique_ptr<HttpsSessionPool> rest_sessions;
+  // One per pooled session, orders are sent from here. Declared after the pool
+  // so it is stopped first.
+  std::unique_ptr<RequestWorkers> order_workers;
+  NonceGenerator nonces;
+  // Set when Kraken.OrderEntry = ws, orders then go over it while it is connected.
+  std::unique_ptr<KrakenWsTrading> ws_trading;
+
+  struct OrderParams {
+    std::string pair;
+    std::string type;
+    std::string volume;
+  };
 
+  Poco::JSON::Object::Ptr send_public_get_request(const std::string& url);
   Poco::JSON::Object::Ptr send_authenticated_post_request(const std::string& url, std::string content);
+  // Market order converting amount of symbol1 into symbol2, false for an unknown pair.
+  bool order_params(const Symbol& symbol1, const Symbol& symbol2, Amount amount, OrderParams& params);
+  OrderResult send_order(const OrderParams& params);
+  std::string fetch_ws_token();
 public:
-  KrakenExchange();
-  bool initialized{};
+  using OrderCallback = std::function<void(const OrderResult&)>;
+
+  struct ReplayStats {
+    uint64_t frames = 0;
+    uint64_t book_frames = 0;
+    uint64_t levels = 0;
+    // Books that failed their checksum, live they would have been resubscribed.
+    uint64_t resyncs = 0;
+    double seconds = 0;
+  };
+
+  // An offline exchange opens no connections and rejects orders, it is fed by replay().
+  explicit KrakenExchange(bool offline = false);
+  // Set once pairs and reference rates are loaded.
+  std::atomic<bool> initialized{false};
+  // Returns at once. Loads the pairs, then connects the book feed while the
+  // reference rates are still loading. With a warm-start cache the feed connects
+  // right away and the pairs are checked against AssetPairs in the background.
   void start_connection_async();
+  // Offline start: pairs come from Kraken.ReplayPairs (a saved AssetPairs response)
+  // or else from the warm-start cache, without its books.
+  void load_pairs_offline();
+  // Feeds a capture through the frame handling of process_ws on the calling thread:
+  // a MarketRecorder recording (a part or the base path of all parts) or a text
+  // file with one frame per line, optionally prefixed by its receive time in unix
+  // seconds or nanoseconds. Runs as fast as possible unless real_time paces it by
+  // the recorded times. on_frame runs after every frame, a strategy driven from
+  // there sees the same book states on every run.
+  ReplayStats replay(const std::string& path, bool real_time, const std::function<void()>& on_frame = {});
   virtual const GenericOrderBook& get_order_book(const Symbol& symbol1, const Symbol& symbol2) override;
   virtual std::vector<std::reference_wrapper<const Symbol>> get_all_symbols() override;
   virtual std::map<std::reference_wrapper<const Symbol>, std::set<std::reference_wrapper<const Symbol>>> get_trading_pairs() override;
   virtual bool has_trading_pair(const Symbol& symbol1, const Symbol& symbol2) override;
+  virtual const TradingGraph& get_trading_graph() override;
+  virtual bool wait_for_changes(std::vector<const GenericOrderBook*>& changed, std::chrono::milliseconds timeout) override;
+  // Queues the order and returns at once. on_done, when set, runs on a worker
+  // thread as soon as the exchange answered.
+  std::future<OrderResult> send_trade_async(const Symbol& symbol1, const Symbol& symbol2, Amount amount,
+                                            OrderCallback on_done = {});
+  // Sends all legs at the same time instead of one round trip after another.
+  // Parallel requests can reach Kraken out of nonce order, the API key needs a
+  // nonce window for that.
+  std::vector<std::future<OrderResult>> send_trades_async(std::span<const TradeLeg> legs, OrderCallback on_done = {});
   bool send_trade_sync(const Symbol& symbol1, const Symbol& symbol2, const uint64_t amount);
 };
\ No newline at end of file
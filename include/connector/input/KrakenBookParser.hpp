@@ -0,0 +1,32 @@
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "OrderBook.hpp"
+
+#pragma once
+
+// One price level change as found in a Kraken book message. Price and volume
+// point straight into the receive buffer, so they are only valid until the
+// next frame is received.
+struct KrakenBookLevel {
+  BookSide side;
+  std::string_view price;
+  std::string_view volume;
+};
+
+// Decoded form of [channelID, {"a"/"b"/"as"/"bs": [[price, volume, ts], ...]}, ..., "book-N", "PAIR"].
+// The level vector is reused between frames, so steady state parsing does not allocate.
+struct KrakenBookFrame {
+  std::string_view channel;
+  std::string_view pair;
+  std::string_view checksum;
+  bool snapshot{};
+  std::vector<KrakenBookLevel> levels;
+
+  void clear();
+};
+
+// Single pass parser for the Kraken book message shape. Returns false for anything
+// that is not a book message (events, heartbeats, other channels, malformed input),
+// the caller is expected to fall back to the generic JSON parser in that case.
+bool parse_kraken_book_frame(const char* data, size_t size, KrakenBookFrame& frame);
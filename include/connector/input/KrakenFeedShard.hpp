@@ -0,0 +1,57 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "LeveledOrderBook.hpp"
+
+#pragma once
+
+// One book feed connection and what its ingest thread owns. A shard only writes
+// books whose writer is its index. Handing a pair to another shard goes through
+// both threads: the old one unsubscribes and lets go of the book, then the new
+// one takes it and subscribes, its snapshot makes the book valid again.
+struct KrakenFeedShard {
+  KrakenFeedShard(uint32_t index, int cpu) : index(index), cpu(cpu) {}
+
+  const uint32_t index;
+  // CPU the ingest thread is pinned to, -1 for none.
+  const int cpu;
+
+  // Ingest thread only.
+  std::vector<LevelUpdate> level_updates;
+  std::vector<std::string> resync_pairs;
+  uint64_t frame_receive_ns = 0;
+  // trace_now() of the frame being handled, received and parsed.
+  uint64_t frame_trace_ns = 0;
+  uint64_t frame_parsed_ns = 0;
+
+  // Subscribed pairs and the handovers posted to the shard, under mutex.
+  std::mutex mutex;
+  std::vector<std::string> pairs;
+  // Pair and the shard taking it over.
+  std::vector<std::pair<std::string, uint32_t>> releases;
+  std::vector<std::string> acquisitions;
+  std::atomic<bool> handovers_pending{false};
+};
+
+// Books written by no shard while they are being handed over.
+inline constexpr uint32_t no_writer = UINT32_MAX;
+
+struct ShardMove {
+  size_t pair;
+  uint32_t from;
+  uint32_t to;
+};
+
+// At most max_moves pair moves that even out the shard loads, rates[i] being the
+// messages per interval of pair i and writers[i] its shard (no_writer pairs stay
+// put). Each move takes the pair of the busiest shard that best halves its gap
+// to the idlest one, until the busiest is within tolerance (0.2 = 20%) of the mean.
+std::vector<ShardMove> plan_shard_moves(std::span<const uint64_t> rates, std::span<const uint32_t> writers,
+                                        uint32_t shard_count, size_t max_moves, double tolerance);
+
+// Pins the calling thread to cpu, false where that is not possible.
+bool pin_thread_to_cpu(int cpu);
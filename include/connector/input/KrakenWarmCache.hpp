@@ -0,0 +1,39 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "LeveledOrderBook.hpp"
+#include "constants.hpp"
+
+#pragma once
+
+// One AssetPairs entry, with base and quote already rewritten to our symbol names.
+struct KrakenPairInfo {
+  std::string name;    // AssetPairs key, used by the REST endpoints
+  std::string wsname;
+  std::string base;
+  std::string quote;
+  unsigned pair_decimals;
+  unsigned lot_decimals;
+
+  bool operator==(const KrakenPairInfo&) const = default;
+};
+
+// What a restart needs to trade-ready books without waiting for REST: the pair
+// metadata (which also defines the symbol table), reference rates and the last
+// levels of every book.
+struct KrakenWarmState {
+  uint64_t saved_at = 0;  // unix seconds
+  uint32_t book_depth = 0;
+  std::vector<KrakenPairInfo> pairs;
+  std::vector<std::pair<std::string, Amount>> reference_rates;
+  // Levels of pairs[i], empty for a book that had no valid snapshot.
+  std::vector<std::vector<LevelUpdate>> books;
+};
+
+// Writes state to a temporary file next to path and renames it over path, so a
+// crash mid-write never leaves a torn cache behind.
+void save_kraken_warm_cache(const std::string& path, const KrakenWarmState& state);
+// Maps path into memory and decodes it. False if the file is missing, of another
+// format version or fails its checksum; state is unspecified then.
+bool load_kraken_warm_cache(const std::string& path, KrakenWarmState& state);
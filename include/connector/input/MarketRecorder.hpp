@@ -0,0 +1,68 @@
+#include <atomic>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <Poco/Logger.h>
+#include "SpscRing.hpp"
+#include "connector/input/MarketRecording.hpp"
+
+#pragma once
+
+// Captures what the ingest thread received into a rolling recording (see
+// MarketRecording.hpp). The ingest thread only copies each frame into a ring,
+// a writer thread encodes and writes it out. When the writer falls behind and
+// the ring fills up, frames are dropped and counted rather than stalling ingest.
+class MarketRecorder {
+public:
+  struct Options {
+    // Parts are written to <path>.0, <path>.1, ...
+    std::string path;
+    RecordingFormat format = RecordingFormat::Raw;
+    size_t ring_bytes = 8 << 20;
+    size_t rotate_bytes = 256 << 20;
+    // Oldest parts beyond this many are deleted, 0 keeps all.
+    size_t max_files = 0;
+  };
+
+  explicit MarketRecorder(const Options& options);
+  // Writes out whatever is still queued.
+  ~MarketRecorder();
+  MarketRecorder(const MarketRecorder&) = delete;
+
+  RecordingFormat get_format() const { return options.format; }
+  // Ingest thread only. record_frame() is ignored by columnar recorders and
+  // record_levels() by raw ones, so callers can feed both unconditionally.
+  void record_frame(uint64_t receive_ns, const char* data, size_t size);
+  void record_levels(uint64_t receive_ns, std::string_view pair, bool snapshot, std::span<const LevelUpdate> levels);
+
+  uint64_t dropped() const { return ring.dropped(); }
+  uint64_t written() const { return records_written.load(std::memory_order_relaxed); }
+  // Wall clock nanoseconds, the timestamp stored with each frame.
+  static uint64_t now_ns();
+private:
+  const Options options;
+  SpscRing ring;
+  std::atomic<bool> running{true};
+  std::atomic<uint64_t> records_written{0};
+  Poco::Logger& logger;
+
+  // Writer thread state.
+  std::ofstream out;
+  size_t file_bytes = 0;
+  uint64_t next_part = 0;
+  std::vector<uint64_t> parts;
+  ColumnarEncoder encoder;
+  std::vector<LevelUpdate> levels;
+  std::string pending;
+  std::vector<char> scratch;
+  bool failed = false;
+  std::thread writer;
+
+  void write_loop();
+  void write_record(std::span<const char> record);
+  void flush_pending();
+  void open_next_part();
+};
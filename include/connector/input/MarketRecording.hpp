@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LeveledOrderBook.hpp"
+
+#pragma once
+
+// A recording is a sequence of files <path>.0, <path>.1, ... each starting with
+// magic "BKMR", u32 version and u32 format.
+//
+// Raw:      per received frame u64 receive_ns, u32 size, the frame text.
+// Columnar: blocks of decoded book frames, "BKCB", u32 frames, u32 levels,
+//           u32 payload size, then the columns names, times, pairs, flags,
+//           counts, sides, prices, volumes, each a u32 size and its bytes.
+//           Integers are LEB128 varints, times and prices are zigzag deltas
+//           (prices against the previous level of the same pair and side),
+//           sides are bit packed and names lists the pairs first seen in the
+//           block. Ids and deltas carry over between the blocks of one file.
+enum class RecordingFormat : uint32_t { Raw = 0, Columnar = 1 };
+
+// One recorded frame. Raw recordings fill `raw` with the received text, columnar
+// ones the decoded pair, snapshot flag and levels. Views are valid until the next
+// read.
+struct RecordedFrame {
+  uint64_t receive_ns = 0;
+  std::string_view raw;
+  std::string_view pair;
+  bool snapshot = false;
+  std::vector<LevelUpdate> levels;
+};
+
+void append_recording_header(std::string& out, RecordingFormat format);
+
+// The parts of a rolling recording in order, <path>.N for increasing N.
+std::vector<std::string> recording_parts(const std::string& path);
+
+// Builds the columnar blocks of one recording file.
+class ColumnarEncoder {
+  std::map<std::string, uint32_t, std::less<>> pair_ids;
+  // Previous ask and bid price per pair id.
+  std::vector<std::pair<__int128, __int128>> last_prices;
+  std::string names, times, pairs, flags, counts, sides, prices, volumes;
+  uint8_t side_bits = 0;
+  unsigned side_bit_count = 0;
+  uint64_t last_ns = 0;
+  uint32_t frame_count = 0, level_count = 0;
+public:
+  void add(uint64_t receive_ns, std::string_view pair, bool snapshot, std::span<const LevelUpdate> levels);
+  uint32_t frames() const { return frame_count; }
+  // Appends the block to out and starts the next one.
+  void flush(std::string& out);
+  // Forgets pair ids and prices, for the first block of a new file.
+  void reset();
+};
+
+// Reads one recording file of either format.
+class MarketRecordingReader {
+  std::ifstream in;
+  RecordingFormat format = RecordingFormat::Raw;
+  std::string buffer;
+
+  struct Column {
+    const char* pos = nullptr;
+    const char* end = nullptr;
+  };
+  std::vector<std::string> pair_names;
+  std::vector<std::pair<__int128, __int128>> last_prices;
+  Column names, times, pairs, flags, counts, sides, prices, volumes;
+  uint32_t frames_left = 0;
+  bool block_start = false;
+  unsigned side_bit = 8;
+  uint8_t side_bits = 0;
+  uint64_t last_ns = 0;
+
+  bool next_block();
+  bool next_columnar(RecordedFrame& frame);
+public:
+  // Throws Poco::FileException if path is not a recording.
+  explicit MarketRecordingReader(const std::string& path);
+  RecordingFormat get_format() const { return format; }
+  // False at the end of the file or at a truncated record.
+  bool next(RecordedFrame& frame);
+};
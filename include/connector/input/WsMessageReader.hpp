@@ -0,0 +1,27 @@
+#include <cstddef>
+#include <Poco/Buffer.h>
+
+#pragma once
+
+namespace Poco::Net {
+class WebSocket;
+}
+
+// Receives whole WebSocket messages: fragments are joined and control frames in
+// between skipped, into a buffer that grows to the largest message seen and is
+// reused. Deep book snapshots run to hundreds of kilobytes.
+class WsMessageReader {
+  Poco::Buffer<char> buffer{0};
+  int message_opcode = 0;
+public:
+  // Blocks until the next message is complete, false once the peer closed the
+  // connection. Exceptions, receive timeouts included, propagate and leave the
+  // connection unusable: Poco cannot resume a frame it stopped reading halfway,
+  // so callers wait with poll() and reconnect on errors.
+  bool receive(Poco::Net::WebSocket& ws);
+  // WebSocket::FRAME_OP_TEXT or FRAME_OP_BINARY.
+  int opcode() const { return message_opcode; }
+  const char* data() const { return buffer.begin(); }
+  size_t size() const { return buffer.size(); }
+  size_t capacity() const { return buffer.capacity(); }
+};
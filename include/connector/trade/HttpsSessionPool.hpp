@@ -0,0 +1,72 @@
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Poco/Net/Context.h>
+#include <Poco/Net/HTTPResponse.h>
+
+#pragma once
+
+namespace Poco {
+class Logger;
+namespace Net {
+class HTTPRequest;
+class HTTPSClientSession;
+}
+}
+
+// Keep-alive HTTPS sessions to one host, connected ahead of time so a request
+// is a write and a read on an open connection instead of a TCP + TLS handshake.
+// A maintenance thread reconnects broken sessions and pings idle ones before
+// the server drops them.
+class HttpsSessionPool {
+public:
+  struct Options {
+    std::string host;
+    unsigned short port = 443;
+    size_t size = 2;
+    // Null uses the default client context of the SSLManager.
+    Poco::Net::Context::Ptr context;
+    std::string ping_path = "/0/public/Time";
+    std::chrono::seconds ping_interval{15};
+    std::chrono::seconds timeout{10};
+  };
+private:
+  struct Slot {
+    std::unique_ptr<Poco::Net::HTTPSClientSession> session;
+    bool leased = false;
+    bool healthy = false;
+    std::chrono::steady_clock::time_point last_used;
+  };
+
+  const Options options;
+  Poco::Logger& logger;
+  std::vector<Slot> slots;
+  std::mutex slots_mutex;
+  std::condition_variable slot_released;
+  std::condition_variable maintenance_wakeup;
+  bool stopping = false;
+  std::thread maintenance;
+
+  Slot& lease_slot();
+  void release_slot(Slot& slot, bool healthy);
+  // GET ping_path on the slot's session, connecting it first if needed.
+  bool ping(Slot& slot);
+  void maintain();
+public:
+  explicit HttpsSessionPool(Options options);
+  ~HttpsSessionPool();
+  HttpsSessionPool(const HttpsSessionPool&) = delete;
+
+  // Sends `request` with `content` as its body over a pooled session and reads the
+  // whole response into `response_content`, leaving the connection reusable.
+  // Waits while all sessions are in use. Failed requests are not retried, the
+  // session is reconnected in the background and the exception propagates.
+  Poco::Net::HTTPResponse::HTTPStatus send(Poco::Net::HTTPRequest& request, const std::string& content,
+                                           std::string& response_content);
+  // Number of idle sessions that passed their last request or ping.
+  size_t healthy_sessions();
+};
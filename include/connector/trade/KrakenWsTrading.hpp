@@ -0,0 +1,86 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <Poco/Net/Context.h>
+#include "connector/trade/Orders.hpp"
+
+#pragma once
+
+namespace Poco {
+class Logger;
+namespace Net {
+class WebSocket;
+}
+}
+
+static const char *const ws_auth_host = "ws-auth.kraken.com";
+
+// Order entry over Kraken's authenticated WebSocket API. The session is opened
+// once with a GetWebSocketsToken token and kept open; each addOrder carries a
+// reqid and its addOrderStatus reply is matched back to the caller's future.
+class KrakenWsTrading {
+public:
+  struct Options {
+    std::string host = ws_auth_host;
+    unsigned short port = 443;
+    std::string path = "/";
+    // Plain ws:// when false, for the local mock server.
+    bool secure = true;
+    // Null uses the default client context of the SSLManager.
+    Poco::Net::Context::Ptr context;
+    // Idle sessions are pinged this often.
+    std::chrono::seconds ping_interval{10};
+  };
+  // Fetches a fresh token, called before every (re)connect.
+  using TokenSource = std::function<std::string()>;
+  using OrderCallback = std::function<void(const OrderResult&)>;
+private:
+  struct PendingOrder {
+    std::promise<OrderResult> promise;
+    OrderCallback on_done;
+    uint64_t sent_ns = 0;
+  };
+
+  const Options options;
+  const TokenSource token_source;
+  Poco::Logger& logger;
+  std::string token;
+  std::unique_ptr<Poco::Net::WebSocket> ws;
+  std::mutex send_mutex;
+  std::mutex pending_mutex;
+  std::unordered_map<uint64_t, PendingOrder> pending;
+  std::atomic<uint64_t> next_reqid{1};
+  std::atomic<bool> is_connected{false};
+  std::atomic<bool> stopping{false};
+  std::thread reader;
+
+  void run();
+  void connect();
+  void handle_message(const std::string& message);
+  void complete(uint64_t reqid, OrderResult result);
+  void fail_pending(const std::string& error);
+  void finish(uint64_t reqid, PendingOrder& order, OrderResult result);
+public:
+  KrakenWsTrading(Options options, TokenSource token_source);
+  ~KrakenWsTrading();
+  KrakenWsTrading(const KrakenWsTrading&) = delete;
+
+  // Connects in the background and keeps reconnecting until destroyed.
+  void start();
+  bool connected() const;
+
+  // Sends a market order for `volume` of the pair's base currency, `type` is
+  // "buy" or "sell" and `pair` the WebSocket name ("XBT/USD"). Returns at once;
+  // on_done, when set, runs on the reader thread with the reply. Orders still in
+  // flight when the session drops fail with an "unknown state" error. Empty when
+  // the session is down, then nothing was sent and on_done is left to the caller.
+  std::optional<std::future<OrderResult>> add_order(const std::string& pair, const std::string& type,
+                                                    const std::string& volume, OrderCallback&& on_done = {});
+};
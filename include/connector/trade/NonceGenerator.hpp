@@ -0,0 +1,24 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#pragma once
+
+// Nonces for private API calls: microseconds since the epoch, strictly increasing
+// across all threads. Calls within the same microsecond, or after the clock
+// stepped back, get the previous nonce + 1.
+class NonceGenerator {
+  std::atomic<uint64_t> last{0};
+public:
+  uint64_t next() {
+    uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t previous = last.load(std::memory_order_relaxed);
+    uint64_t nonce;
+    do {
+      nonce = std::max(now, previous + 1);
+    } while (!last.compare_exchange_weak(previous, nonce, std::memory_order_relaxed));
+    return nonce;
+  }
+};
@@ -0,0 +1,20 @@
+#include <string>
+#include <vector>
+#include "Symbol.hpp"
+
+#pragma once
+
+// One market order converting `amount` of `from` into `to`.
+struct TradeLeg {
+  const Symbol& from;
+  const Symbol& to;
+  Amount amount;
+};
+
+// Outcome of an order as reported by the exchange. `ok` means accepted with at
+// least one txid; transport failures and HTTP errors end up in `errors` too.
+struct OrderResult {
+  bool ok = false;
+  std::vector<std::string> txids;
+  std::vector<std::string> errors;
+};
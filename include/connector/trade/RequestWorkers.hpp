@@ -0,0 +1,40 @@
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#pragma once
+
+// Fixed set of threads running blocking requests, so callers get a future back
+// immediately and independent requests (e.g. the legs of a cycle) are in flight
+// at the same time. Sized like the session pool they send through.
+class RequestWorkers {
+  std::vector<std::thread> threads;
+  std::deque<std::function<void()>> tasks;
+  std::mutex tasks_mutex;
+  std::condition_variable task_added;
+  bool stopping = false;
+
+  void run();
+public:
+  explicit RequestWorkers(size_t count);
+  // Runs the queued tasks before returning.
+  ~RequestWorkers();
+  RequestWorkers(const RequestWorkers&) = delete;
+
+  template <class Task>
+  auto submit(Task&& task) -> std::future<decltype(task())> {
+    auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::forward<Task>(task));
+    std::future<decltype(task())> rv = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(tasks_mutex);
+      tasks.emplace_back([packaged] { (*packaged)(); });
+    }
+    task_added.notify_one();
+    return rv;
+  }
+};
@@ -1,15 +1,21 @@
 #include <cstdint>
+#include <string>
+#include "Decimal.hpp"
 #pragma once
 
 static const uint64_t decimals = 8;
 static const uint64_t dec_power = 100000000LL;
 
-inline std::string amount_to_string(const uint64_t amount) {
-  std::string s = std::to_string(amount);
-  if (s.size() < 9)
-  {
-    s = std::string(9 - s.size(), '0') + s;
-  }
-  s.insert(s.size() - 8, ".");
-  return s;
+// Prices and volumes are kept with `decimals` fractional digits, which covers
+// the pair_decimals/lot_decimals of all Kraken pairs we trade.
+using Amount = Decimal<decimals>;
+
+inline std::string amount_to_string(const Amount amount, unsigned precision = decimals) {
+  return amount.to_string(precision);
+}
+
+// For order volumes: cut rather than rounded, so an order never asks for more
+// than the amount it was sized from.
+inline std::string volume_to_string(const Amount amount, unsigned precision) {
+  return amount.truncated(precision).to_string(precision);
 }
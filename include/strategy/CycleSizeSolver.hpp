@@ -0,0 +1,30 @@
+#include <span>
+#include <vector>
+#include "TradingPairTable.hpp"
+
+#pragma once
+
+// Converts `amount` through the legs in order, paying each leg's fee, priced on
+// the books.
+Amount convert_along(std::span<const BookHandle> legs, Amount amount);
+
+// Finds the input that maximises amount_out - amount_in along a chain of books.
+// Every leg converts along a concave piecewise linear curve (best levels first),
+// so does the whole chain, and the optimum is the breakpoint where the marginal
+// rate of the chain drops to one. solve() walks the breakpoints of all legs in
+// input order instead of sampling sizes, then prices the found size exactly.
+class CycleSizeSolver {
+public:
+  struct Result {
+    Amount amount_in;
+    Amount amount_out;
+  };
+private:
+  std::vector<std::vector<ConversionSegment>> curves;
+  std::vector<size_t> positions;
+  std::vector<double> remaining;
+  std::vector<double> fee_keep;
+public:
+  // Zero amount_in when no size returns more than it takes.
+  Result solve(std::span<const BookHandle> legs);
+};
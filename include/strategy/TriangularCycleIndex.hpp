@@ -0,0 +1,53 @@
+#include <array>
+#include <functional>
+#include <span>
+#include <vector>
+#include "TradingGraph.hpp"
+#include "strategy/CycleSizeSolver.hpp"
+
+#pragma once
+
+// All 3-cycles start -> a -> b -> start of a trading graph, built once. Cycles are
+// grouped by start symbol and indexed by the books their legs trade on, so an
+// update of one book reprices only the cycles running through it.
+class TriangularCycleIndex {
+public:
+  struct Cycle {
+    uint32_t start;
+    std::array<BookHandle, 3> legs;
+  };
+  using Callback = std::function<void(const Cycle& cycle, Amount amount_in, Amount amount_out)>;
+private:
+  const TradingGraph& graph;
+  std::vector<Cycle> cycles;
+  std::vector<uint32_t> cycles_by_start;
+  // Reverse index: books sorted by address, book_cycle_offsets[i] .. [i + 1] are
+  // the positions in book_cycles of the cycles trading on books[i].
+  std::vector<const LeveledOrderBook*> books;
+  std::vector<uint32_t> book_cycle_offsets;
+  std::vector<uint32_t> book_cycles;
+  // Scratch for reprice(), a cycle is picked once per call when its stamp matches.
+  std::vector<uint32_t> cycle_stamps;
+  std::vector<uint32_t> pending;
+  uint32_t stamp = 0;
+  CycleSizeSolver solver;
+
+  // Fills pending with the cycles trading on one of the changed books, each once.
+  void collect(std::span<const GenericOrderBook* const> changed);
+  size_t evaluate(const Cycle& cycle, Amount base_amount, const Callback& callback) const;
+public:
+  explicit TriangularCycleIndex(const TradingGraph& graph);
+
+  size_t size() const { return cycles.size(); }
+  std::span<const Cycle> cycles_from(uint32_t start) const;
+
+  // Prices every cycle that trades on one of the changed books with base_amount
+  // worth of its start symbol (using the symbol reference rate) and calls back
+  // with the ones returning more than they take. Returns the number found.
+  size_t reprice(std::span<const GenericOrderBook* const> changed, Amount base_amount, const Callback& callback);
+  // Same over every cycle.
+  size_t reprice_all(Amount base_amount, const Callback& callback);
+  // Like reprice(), but each cycle is sized by CycleSizeSolver to the amount
+  // returning the most instead of a fixed base amount.
+  size_t reprice_optimal(std::span<const GenericOrderBook* const> changed, const Callback& callback);
+};
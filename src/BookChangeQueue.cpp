@@ -0,0 +1,27 @@
+#include "BookChangeQueue.hpp"
+#include "LeveledOrderBook.hpp"
+
+void BookChangeQueue::push(const LeveledOrderBook& book) {
+  if (book.change_queued.exchange(true, std::memory_order_acq_rel))
+    return;
+  {
+    const std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(&book);
+  }
+  changed.notify_one();
+}
+
+bool BookChangeQueue::wait(std::vector<const LeveledOrderBook*>& books, std::chrono::milliseconds timeout) {
+  books.clear();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!changed.wait_for(lock, timeout, [this]() { return !pending.empty(); }))
+      return false;
+    books.swap(pending);
+  }
+  // Cleared before the consumer reads the books, so a change made while it is
+  // evaluating queues the book again.
+  for (const LeveledOrderBook* book : books)
+    book->change_queued.store(false, std::memory_order_release);
+  return true;
+}
@@ -9,7 +9,8 @@
 #include <Poco/PatternFormatter.h>
 
 #include "connector/input/Kraken.hpp"
-#include "strategy/TriangularArbitrageFinder.hpp"
+#include "strategy/TriangularCycleIndex.hpp"
+#include "LatencyTrace.hpp"
 #include "Utils.hpp"
 #include "Symbol.hpp"
 
@@ -30,29 +31,63 @@ void test_ob(KrakenExchange* kraken) {
   } while(true);
 }
 
+void print_arbitrage(const TriangularCycleIndex::Cycle& cycle, Amount amount_in, Amount amount_out) {
+  std::cout << "Arbitrage found: " << amount_in.to_string() << cycle.legs[0].generic->get_symbol_1().get_symbol();
+  for (const BookHandle& leg : cycle.legs) {
+    std::cout << " -> " << leg.generic->get_symbol_2().get_symbol();
+  }
+  std::cout << " = " << amount_out.to_string();
+  // Books restored from the warm-start cache until their live snapshot arrives.
+  for (const BookHandle& leg : cycle.legs) {
+    if (leg.book->is_stale()) {
+      std::cout << " (stale)";
+      break;
+    }
+  }
+  std::cout << std::endl;
+}
+
 void try_find_arbitrage(KrakenExchange* kraken) {
-  std::this_thread::sleep_for(std::chrono::milliseconds(3000));
-  std::vector<std::reference_wrapper<const Symbol>> symbols = kraken->get_all_symbols();
-  TriangularArbitrageFinder finder(*kraken);
+  std::vector<const GenericOrderBook*> changed;
+  while (!kraken->wait_for_changes(changed, std::chrono::milliseconds(1000)));
+  TriangularCycleIndex cycles(kraken->get_trading_graph());
+  std::cout << "Watching " << cycles.size() << " triangular cycles" << std::endl;
+
+  TriangularCycleIndex::Callback callback = print_arbitrage;
   do {
-    std::function<void(std::vector<std::pair<__int128, std::reference_wrapper<const GenericOrderBook>>>)> callback =
-        [](std::vector<std::pair<__int128, std::reference_wrapper<const GenericOrderBook>>> path) {
-          std::cout << "Arbitrage found: ";
-          for (const auto [exchanged, ob] : path) {
-            std::cout << exchanged << ob.get().get_symbol_1().get_symbol() << " -> ";
-          }
-          std::cout << path.back().second.get().estimate_conversion_from_1(path.back().first)
-                    << path.back().second.get().get_symbol_2().get_symbol() << std::endl;
-        };
-
-    int arbitrages_found = finder.calculate_optimal_rates(callback, 100 * dec_power);
+    // Only cycles running through the books that changed since the last pass are repriced,
+    // each at the size returning the most.
+    size_t arbitrages_found = cycles.reprice_optimal(changed, callback);
 
     if (arbitrages_found > 0)
       std::cout << "Found " << arbitrages_found << "arbitrages" << "\n\n";
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Sleep until a book changes instead of polling, quiet markets cost nothing.
+    while (!kraken->wait_for_changes(changed, std::chrono::milliseconds(1000)));
   } while(true);
 }
   
+// Runs the strategy over a capture instead of the live feed, after every frame on
+// the replaying thread so the output is the same on every run.
+void replay_capture(const std::string& path) {
+  KrakenExchange kraken(true);
+  kraken.load_pairs_offline();
+  TriangularCycleIndex cycles(kraken.get_trading_graph());
+  std::cout << "Watching " << cycles.size() << " triangular cycles" << std::endl;
+
+  std::vector<const GenericOrderBook*> changed;
+  size_t arbitrages_found = 0;
+  KrakenExchange::ReplayStats stats = kraken.replay(path, config->getBool("Booker.ReplayRealTime", false), [&] {
+    if (kraken.wait_for_changes(changed, std::chrono::milliseconds(0)))
+      arbitrages_found += cycles.reprice_optimal(changed, print_arbitrage);
+  });
+  std::cout << "Replayed " << stats.frames << " frames, " << stats.book_frames << " book frames, " << stats.levels
+            << " levels, " << stats.resyncs << " checksum failures in " << stats.seconds << " s: "
+            << stats.frames / stats.seconds << " frames/s, " << stats.levels / stats.seconds << " levels/s, "
+            << arbitrages_found << " arbitrages" << std::endl;
+  for (const auto& [span, summary] : take_latency_summaries())
+    std::cout << format_latency_summary(span, summary) << "\n";
+}
+
 Poco::AutoPtr<Poco::Util::IniFileConfiguration> config(new Poco::Util::IniFileConfiguration("./Booker.ini"));
 int test_send();
 
@@ -75,6 +110,16 @@ int main() {
 
   poco_notice(logger2, "Starting application");
 
+  std::string replay_path = config->getString("Booker.Replay", "");
+  if (!replay_path.empty()) {
+    replay_capture(replay_path);
+    return 0;
+  }
+
+  if constexpr (latency_trace_enabled)
+    start_latency_reports(std::chrono::seconds(config->getInt("Booker.LatencyReportInterval", 10)),
+                          config->getString("Booker.LatencyReportFile", "latency.jsonl"));
+
   test_send();
 
   KrakenExchange kraken;
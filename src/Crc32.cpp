@@ -0,0 +1,45 @@
+#include <array>
+#include <cstring>
+#include "Crc32.hpp"
+
+namespace {
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+  Tables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int bit = 0; bit < 8; bit++)
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    tables[0][i] = c;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int slice = 1; slice < 8; slice++)
+      tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xff];
+  }
+  return tables;
+}
+
+constexpr Tables tables = make_tables();
+} //namespace
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  uint32_t c = ~crc;
+
+  // Little endian word loads, fine for the x86-64 and arm64 hosts we run on.
+  while (size >= 8) {
+    uint32_t one, two;
+    std::memcpy(&one, p, 4);
+    std::memcpy(&two, p + 4, 4);
+    one ^= c;
+    c = tables[7][one & 0xff] ^ tables[6][(one >> 8) & 0xff] ^ tables[5][(one >> 16) & 0xff] ^ tables[4][one >> 24] ^
+        tables[3][two & 0xff] ^ tables[2][(two >> 8) & 0xff] ^ tables[1][(two >> 16) & 0xff] ^ tables[0][two >> 24];
+    p += 8;
+    size -= 8;
+  }
+  while (size-- > 0)
+    c = tables[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+
+  return ~c;
+}
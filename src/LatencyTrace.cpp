@@ -0,0 +1,121 @@
+#include <Poco/Logger.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#include "LatencyTrace.hpp"
+
+namespace {
+static const char* const span_names[] = {
+  "parse", "apply", "detect", "tick_to_detect", "order_queue", "order_round_trip", "tick_to_trade"
+};
+static_assert(std::size(span_names) == static_cast<size_t>(TraceSpan::Count));
+
+// 32.32 ns per TSC tick, measured against steady_clock. Zero without an
+// invariant TSC, whose rate would change with the CPU frequency.
+uint64_t calibrate_tsc() {
+  if constexpr (!latency_trace_enabled)
+    return 0;
+#if defined(__x86_64__)
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0 || (edx & (1 << 8)) == 0)
+    return 0;
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t start_tsc = __rdtsc();
+  while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20));
+  const uint64_t ticks = __rdtsc() - start_tsc;
+  const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  return ticks == 0 ? 0 : (static_cast<unsigned __int128>(ns) << 32) / ticks;
+#else
+  return 0;
+#endif
+}
+} //namespace
+
+std::array<LatencyHistogram, static_cast<size_t>(TraceSpan::Count)> latency_detail::histograms;
+uint64_t latency_detail::tsc_to_ns = calibrate_tsc();
+
+const char* trace_span_name(TraceSpan span) {
+  return span_names[static_cast<size_t>(span)];
+}
+
+LatencyHistogram::Summary LatencyHistogram::take() {
+  // Samples recorded while this runs count towards either report.
+  std::array<uint64_t, bucket_count> taken;
+  Summary rv;
+  for (size_t i = 0; i < bucket_count; i++) {
+    taken[i] = counts[i].exchange(0, std::memory_order_relaxed);
+    rv.count += taken[i];
+  }
+  const uint64_t taken_sum = sum.exchange(0, std::memory_order_relaxed);
+  rv.max = max.exchange(0, std::memory_order_relaxed);
+  if (rv.count == 0)
+    return rv;
+  rv.mean = double(taken_sum) / rv.count;
+
+  // Smallest bucket covering the given share of the samples.
+  uint64_t seen = 0;
+  size_t i = 0;
+  auto percentile = [&](double share) {
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(share * rv.count + 0.5));
+    while (seen < target && i < bucket_count)
+      seen += taken[i++];
+    return std::min(highest_value(i - 1), rv.max);
+  };
+  rv.p50 = percentile(0.5);
+  rv.p99 = percentile(0.99);
+  rv.p999 = percentile(0.999);
+  return rv;
+}
+
+std::vector<std::pair<TraceSpan, LatencyHistogram::Summary>> take_latency_summaries() {
+  std::vector<std::pair<TraceSpan, LatencyHistogram::Summary>> rv;
+  for (size_t i = 0; i < latency_detail::histograms.size(); i++) {
+    LatencyHistogram::Summary summary = latency_detail::histograms[i].take();
+    if (summary.count > 0)
+      rv.emplace_back(static_cast<TraceSpan>(i), summary);
+  }
+  return rv;
+}
+
+std::string format_latency_summary(TraceSpan span, const LatencyHistogram::Summary& summary) {
+  char text[192];
+  std::snprintf(text, sizeof(text), "%-16s n=%-8llu mean %9.2f us  p50 %9.2f us  p99 %9.2f us  p99.9 %9.2f us  max %9.2f us",
+                trace_span_name(span), static_cast<unsigned long long>(summary.count), summary.mean / 1000,
+                summary.p50 / 1000.0, summary.p99 / 1000.0, summary.p999 / 1000.0, summary.max / 1000.0);
+  return text;
+}
+
+void start_latency_reports(std::chrono::seconds interval, const std::string& path) {
+  std::thread reporter([interval, path] {
+    Poco::Logger& logger = Poco::Logger::root().get("Latency");
+    std::ofstream out;
+    if (!path.empty()) {
+      out.open(path, std::ios::app);
+      if (!out)
+        poco_error(logger, "Cannot open " + path + ", latency reports go to the log only");
+    }
+    poco_notice(logger, std::string("Reporting latencies every ") + std::to_string(interval.count()) + " s"
+                + (latency_detail::tsc_to_ns != 0 ? " using the TSC" : " using steady_clock"));
+    while (true) {
+      std::this_thread::sleep_for(interval);
+      const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+      for (const auto& [span, summary] : take_latency_summaries()) {
+        poco_notice(logger, format_latency_summary(span, summary));
+        if (out.is_open()) {
+          out << "{\"time_ms\":" << now << ",\"span\":\"" << trace_span_name(span) << "\",\"count\":" << summary.count
+              << ",\"mean_ns\":" << static_cast<uint64_t>(summary.mean) << ",\"p50_ns\":" << summary.p50
+              << ",\"p99_ns\":" << summary.p99 << ",\"p999_ns\":" << summary.p999 << ",\"max_ns\":" << summary.max << "}\n";
+        }
+      }
+      out.flush();
+    }
+  });
+  reporter.detach();
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "LevelSearch.hpp"
+
+namespace {
+// Branchless binary search down to a window of `block` entries: afterwards the
+// count is pos + the number of sorted[pos .. pos + block) not greater than key.
+inline size_t narrow_to_block(const int64_t* sorted, size_t padded, int64_t key, size_t block) {
+  size_t pos = 0;
+  for (size_t step = padded / 2; step >= block; step >>= 1)
+    pos += sorted[pos + step - 1] <= key ? step : 0;
+  return pos;
+}
+
+void count_scalar(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts) {
+  for (size_t i = 0; i < n; i++)
+    counts[i] = narrow_to_block(sorted, padded, keys[i], 1);
+}
+
+#if defined(__x86_64__)
+// The vector kernels finish the search with contiguous compares over the last
+// window instead of gathers, which are slow on most cores.
+const size_t avx2_block = 8;
+const size_t avx512_block = 16;
+
+__attribute__((target("avx2,popcnt")))
+void count_avx2(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts) {
+  if (padded < 4)
+    return count_scalar(sorted, padded, keys, n, counts);
+  const size_t block = std::min(padded, avx2_block);
+  for (size_t i = 0; i < n; i++) {
+    size_t pos = narrow_to_block(sorted, padded, keys[i], block);
+    __m256i key = _mm256_set1_epi64x(keys[i]);
+    unsigned greater = 0;
+    for (size_t j = 0; j < block; j += 4) {
+      __m256i entries = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sorted + pos + j));
+      greater += std::popcount(unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(entries, key)))));
+    }
+    counts[i] = pos + block - greater;
+  }
+}
+
+__attribute__((target("avx512f,popcnt")))
+void count_avx512(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts) {
+  if (padded < 8)
+    return count_scalar(sorted, padded, keys, n, counts);
+  const size_t block = std::min(padded, avx512_block);
+  for (size_t i = 0; i < n; i++) {
+    size_t pos = narrow_to_block(sorted, padded, keys[i], block);
+    __m512i key = _mm512_set1_epi64(keys[i]);
+    unsigned not_greater = 0;
+    for (size_t j = 0; j < block; j += 8) {
+      __m512i entries = _mm512_loadu_si512(sorted + pos + j);
+      not_greater += std::popcount(unsigned(_mm512_cmple_epi64_mask(entries, key)));
+    }
+    counts[i] = pos + not_greater;
+  }
+}
+#endif
+
+bool supported(SearchIsa isa) {
+#if defined(__x86_64__)
+  // Runs from static initialisation, possibly before libgcc has set up the cpu model.
+  __builtin_cpu_init();
+  if (isa == SearchIsa::Avx512)
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+  if (isa == SearchIsa::Avx2)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+  return isa == SearchIsa::Scalar;
+}
+
+CountKernel kernel_for(SearchIsa isa) {
+#if defined(__x86_64__)
+  if (isa == SearchIsa::Avx512)
+    return count_avx512;
+  if (isa == SearchIsa::Avx2)
+    return count_avx2;
+#endif
+  return count_scalar;
+}
+
+std::atomic<SearchIsa> active_isa{best_search_isa()};
+std::atomic<CountKernel> active_kernel{kernel_for(best_search_isa())};
+} //namespace
+
+void count_not_greater(const int64_t* sorted, size_t padded, const int64_t* keys, size_t n, uint32_t* counts) {
+  active_kernel.load(std::memory_order_relaxed)(sorted, padded, keys, n, counts);
+}
+
+SearchIsa best_search_isa() {
+  if (supported(SearchIsa::Avx512))
+    return SearchIsa::Avx512;
+  if (supported(SearchIsa::Avx2))
+    return SearchIsa::Avx2;
+  return SearchIsa::Scalar;
+}
+
+bool use_search_isa(SearchIsa isa) {
+  if (!supported(isa))
+    return false;
+  active_isa.store(isa, std::memory_order_relaxed);
+  active_kernel.store(kernel_for(isa), std::memory_order_relaxed);
+  return true;
+}
+
+SearchIsa active_search_isa() {
+  return active_isa.load(std::memory_order_relaxed);
+}
+
+const char* search_isa_name(SearchIsa isa) {
+  switch (isa) {
+    case SearchIsa::Avx512: return "avx512";
+    case SearchIsa::Avx2: return "avx2";
+    default: return "scalar";
+  }
+}
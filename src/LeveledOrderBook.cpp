@@ -1,39 +1,290 @@
-
 #include <algorithm>
 #include <sstream>
 #include "LeveledOrderBook.hpp"
 #include "constants.hpp"
+#include "Crc32.hpp"
 #include "Utils.hpp"
 
 namespace {
-static const int ob_depth = 10;
+// Sells `requested` of symbol1 into the bids. Notional is summed unrounded
+// (scaled by Amount::one twice) and rounded once at the end.
+template <class Side>
+Amount convert_from_1(const Side& bids, Amount requested) {
+  Amount volume_consumed;
+  __int128 received = 0;
+  bids.for_each([&](const Amount& price_at_level, const Amount& volume_at_level) {
+    Amount exchanging = std::min(volume_at_level, requested - volume_consumed);
+    volume_consumed += exchanging;
+    received += exchanging.raw() * price_at_level.raw();
+    return volume_consumed < requested;
+  });
+  return Amount::from_product(received);
 }
 
-LeveledOrderBook::LeveledOrderBook(const Symbol& s1, const Symbol& s2) : symbol1(s1), symbol2(s2) {
+// Spends `requested` of symbol2 on the asks. Fully consumed levels yield their
+// volume exactly, only the last partially consumed level needs a division.
+// A non-positive price can only be a torn seqlock read, which gets retried.
+template <class Side>
+Amount convert_from_2(const Side& asks, Amount requested) {
+  __int128 remaining = requested.raw() * Amount::one;
+  Amount received;
+  asks.for_each([&](const Amount& price_at_level, const Amount& volume_at_level) {
+    if (price_at_level.raw() <= 0)
+      return false;
+    __int128 level_notional = volume_at_level.raw() * price_at_level.raw();
+    if (level_notional > remaining) {
+      received += Amount::from_raw(decimal_detail::div_round(remaining, price_at_level.raw()));
+      remaining = 0;
+      return false;
+    }
+    received += volume_at_level;
+    remaining -= level_notional;
+    return remaining > 0;
+  });
+  return received;
 }
 
-LeveledOrderBook::LeveledOrderBook(LeveledOrderBook&& other) : symbol1(other.symbol1), symbol2(other.symbol2) {
-  bids = std::move(other.bids);
-  asks = std::move(other.asks);
+// Amount of symbol1 to sell into the bids to receive `target` of symbol2, rounded up.
+template <class Side>
+Amount required_from_1(const Side& bids, Amount target) {
+  __int128 remaining = target.raw() * Amount::one;
+  Amount required;
+  bids.for_each([&](const Amount& price_at_level, const Amount& volume_at_level) {
+    if (price_at_level.raw() <= 0)
+      return false;
+    __int128 level_notional = volume_at_level.raw() * price_at_level.raw();
+    if (level_notional >= remaining) {
+      required += Amount::from_raw((remaining + price_at_level.raw() - 1) / price_at_level.raw());
+      remaining = 0;
+      return false;
+    }
+    required += volume_at_level;
+    remaining -= level_notional;
+    return true;
+  });
+  return remaining > 0 ? -Amount::from_raw(1) : required;
 }
 
-std::string LeveledOrderBook::print() const {
-  std::stringstream ss;
-  ss << "Bid_size: "  << bids.size() << ", ask_size: " << asks.size() << "\n" << "  Bids: \n";
-  for (const auto& b : bids) {
-    ss << "    " << b.first << " : " << b.second << "\n";
+// Amount of symbol2 to spend on the asks to receive `target` of symbol1, rounded up.
+template <class Side>
+Amount required_from_2(const Side& asks, Amount target) {
+  Amount volume_consumed;
+  __int128 required = 0;
+  asks.for_each([&](const Amount& price_at_level, const Amount& volume_at_level) {
+    Amount exchanging = std::min(volume_at_level, target - volume_consumed);
+    volume_consumed += exchanging;
+    required += exchanging.raw() * price_at_level.raw();
+    return volume_consumed < target;
+  });
+  if (volume_consumed < target)
+    return -Amount::from_raw(1);
+  return Amount::from_raw((required + Amount::one - 1) / Amount::one);
+}
+
+// Flat sides answer the same four questions from their cumulative arrays with a
+// binary search and one interpolation step, with results identical to the walks.
+// The finish_* steps take the number of fully consumed levels, so the batch forms
+// below can get those from one search over many amounts.
+
+template <class Better>
+Amount finish_from_1(const FlatBookSide<Better>& bids, Amount requested, size_t full) {
+  __int128 received = bids.cumulative_notional(full);
+  if (full < bids.size())
+    received += (requested - bids.cumulative_volume(full)).raw() * bids.price(full).raw();
+  return Amount::from_product(received);
+}
+
+template <class Better>
+Amount finish_from_2(const FlatBookSide<Better>& asks, Amount requested, size_t full) {
+  Amount received = asks.cumulative_volume(full);
+  if (full < asks.size()) {
+    __int128 price = asks.price(full).raw();
+    if (price <= 0)
+      return Amount();
+    received += Amount::from_raw(decimal_detail::div_round(requested.raw() * Amount::one - asks.cumulative_notional(full), price));
   }
-  ss << "  Asks: \n";
-  for (const auto& a : asks) {
-    ss << "    " << a.first << " : " << a.second << "\n";
+  return received;
+}
+
+template <class Better>
+Amount convert_from_1(const FlatBookSide<Better>& bids, Amount requested) {
+  return finish_from_1(bids, requested, bids.levels_within_volume(requested));
+}
+
+template <class Better>
+Amount convert_from_2(const FlatBookSide<Better>& asks, Amount requested) {
+  return finish_from_2(asks, requested, asks.levels_within_notional(requested.raw() * Amount::one));
+}
+
+template <class Better>
+Amount required_from_1(const FlatBookSide<Better>& bids, Amount target) {
+  __int128 wanted = target.raw() * Amount::one;
+  size_t full = bids.levels_within_notional(wanted);
+  __int128 missing = wanted - bids.cumulative_notional(full);
+  if (missing == 0)
+    return bids.cumulative_volume(full);
+  if (full == bids.size())
+    return -Amount::from_raw(1);
+  __int128 price = bids.price(full).raw();
+  if (price <= 0)
+    return Amount();
+  return bids.cumulative_volume(full) + Amount::from_raw((missing + price - 1) / price);
+}
+
+template <class Better>
+Amount required_from_2(const FlatBookSide<Better>& asks, Amount target) {
+  size_t full = asks.levels_within_volume(target);
+  Amount missing = target - asks.cumulative_volume(full);
+  if (!missing.is_zero() && full == asks.size())
+    return -Amount::from_raw(1);
+  __int128 required = asks.cumulative_notional(full);
+  if (!missing.is_zero())
+    required += missing.raw() * asks.price(full).raw();
+  return Amount::from_raw((required + Amount::one - 1) / Amount::one);
+}
+
+// Amounts are searched in chunks small enough for stack scratch.
+const size_t batch_chunk = 64;
+
+// Runs search() over the amounts chunk by chunk and out[i] = finish(amounts[i], levels).
+// Amounts outside the int64 range the search works on get single(amount) levels.
+template <class Search, class Single, class Finish>
+void search_batch(std::span<const Amount> amounts, std::span<Amount> out, size_t size,
+                  Search&& search, Single&& single, Finish&& finish) {
+  int64_t keys[batch_chunk];
+  uint32_t levels[batch_chunk];
+  for (size_t begin = 0; begin < amounts.size(); begin += batch_chunk) {
+    size_t n = std::min(batch_chunk, amounts.size() - begin);
+    for (size_t i = 0; i < n; i++)
+      keys[i] = int64_t(std::clamp<__int128>(amounts[begin + i].raw(), INT64_MIN, INT64_MAX - 1));
+    search(keys, n, levels);
+    for (size_t i = 0; i < n; i++) {
+      Amount amount = amounts[begin + i];
+      size_t full = amount.raw() == keys[i] ? std::min<size_t>(levels[i], size) : single(amount);
+      out[begin + i] = finish(amount, full);
+    }
   }
-  return ss.str();
+}
+
+template <class Side>
+void convert_batch_from_1(const Side& bids, std::span<const Amount> amounts, std::span<Amount> out) {
+  for (size_t i = 0; i < amounts.size(); i++)
+    out[i] = convert_from_1(bids, amounts[i]);
+}
+
+template <class Side>
+void convert_batch_from_2(const Side& asks, std::span<const Amount> amounts, std::span<Amount> out) {
+  for (size_t i = 0; i < amounts.size(); i++)
+    out[i] = convert_from_2(asks, amounts[i]);
+}
+
+template <class Better>
+void convert_batch_from_1(const FlatBookSide<Better>& bids, std::span<const Amount> amounts, std::span<Amount> out) {
+  search_batch(amounts, out, bids.size(),
+      [&](const int64_t* keys, size_t n, uint32_t* levels) { bids.levels_within_volumes(keys, n, levels); },
+      [&](Amount amount) { return bids.levels_within_volume(amount); },
+      [&](Amount amount, size_t full) { return finish_from_1(bids, amount, full); });
+}
+
+template <class Better>
+void convert_batch_from_2(const FlatBookSide<Better>& asks, std::span<const Amount> amounts, std::span<Amount> out) {
+  search_batch(amounts, out, asks.size(),
+      [&](const int64_t* keys, size_t n, uint32_t* levels) { asks.levels_within_notionals(keys, n, levels); },
+      [&](Amount amount) { return asks.levels_within_notional(amount.raw() * Amount::one); },
+      [&](Amount amount, size_t full) { return finish_from_2(asks, amount, full); });
+}
+
+// Feeds `value` printed with `digits` decimals to the crc, without the decimal
+// point and leading zeros as Kraken's checksum wants it.
+uint32_t crc_level_value(uint32_t crc, Amount value, unsigned digits) {
+  unsigned __int128 wide = value.raw();
+  if (digits < decimals)
+    wide /= decimal_detail::pow10(decimals - digits);
+  else
+    wide *= decimal_detail::pow10(digits - decimals);
+
+  char buffer[40];
+  char* end = buffer + sizeof(buffer);
+  char* d = end;
+  if (wide <= UINT64_MAX) {
+    uint64_t narrow = wide;
+    do {
+      *--d = char('0' + narrow % 10);
+      narrow /= 10;
+    } while (narrow != 0);
+  } else {
+    do {
+      *--d = char('0' + wide % 10);
+      wide /= 10;
+    } while (wide != 0);
+  }
+  return crc32(d, end - d, crc);
+}
+} //namespace
+
+LeveledOrderBook::LeveledOrderBook(const Symbol& s1, const Symbol& s2, unsigned pair_decimals, unsigned lot_decimals,
+                                   size_t depth, BookStorage storage) :
+    storage(storage),
+    map_bids(depth), map_asks(depth),
+    flat_bids(storage == BookStorage::Flat ? depth : 0), flat_asks(storage == BookStorage::Flat ? depth : 0),
+    symbol1(s1), symbol2(s2), pair_decimals(pair_decimals), lot_decimals(lot_decimals) {
+}
+
+LeveledOrderBook::LeveledOrderBook(LeveledOrderBook&& other) :
+    storage(other.storage),
+    map_bids(std::move(other.map_bids)), map_asks(std::move(other.map_asks)),
+    flat_bids(std::move(other.flat_bids)), flat_asks(std::move(other.flat_asks)),
+    symbol1(other.symbol1), symbol2(other.symbol2), pair_decimals(other.pair_decimals), lot_decimals(other.lot_decimals),
+    generation(other.generation.load()), valid(other.valid.load()), stale(other.stale.load()),
+    checksum_enabled(other.checksum_enabled.load()) {
+}
+
+std::string LeveledOrderBook::print() const {
+  return read_sides([&](const auto& asks, const auto& bids) {
+    std::stringstream ss;
+    auto print_level = [&](const Amount& price, const Amount& volume) {
+      ss << "    " << price.to_string(pair_decimals) << " : " << volume.to_string(lot_decimals) << "\n";
+      return true;
+    };
+    ss << "Bid_size: "  << bids.size() << ", ask_size: " << asks.size() << "\n" << "  Bids: \n";
+    bids.for_each(print_level);
+    ss << "  Asks: \n";
+    asks.for_each(print_level);
+    return ss.str();
+  });
 }
 
 const Symbol& LeveledOrderBook::get_symbol_1() const { return symbol1; }
 const Symbol& LeveledOrderBook::get_symbol_2() const { return symbol2; }
+unsigned LeveledOrderBook::get_pair_decimals() const { return pair_decimals; }
+unsigned LeveledOrderBook::get_lot_decimals() const { return lot_decimals; }
+BookStorage LeveledOrderBook::get_storage() const { return storage; }
+uint64_t LeveledOrderBook::get_generation() const { return generation.load(std::memory_order_acquire); }
+bool LeveledOrderBook::is_valid() const { return valid.load(std::memory_order_acquire); }
+bool LeveledOrderBook::is_stale() const { return stale.load(std::memory_order_acquire); }
+uint64_t LeveledOrderBook::get_trace_received_ns() const { return trace_received_ns.load(std::memory_order_relaxed); }
+uint64_t LeveledOrderBook::get_trace_updated_ns() const { return trace_updated_ns.load(std::memory_order_relaxed); }
+bool LeveledOrderBook::supports_checksum() const {
+  return pair_decimals <= decimals && lot_decimals <= decimals && checksum_enabled.load(std::memory_order_relaxed);
+}
 
-__int128 LeveledOrderBook::estimate_conversion_from_1(__int128 amount) const {
+uint32_t LeveledOrderBook::checksum() const {
+  return read_sides([&](const auto& asks, const auto& bids) {
+    uint32_t crc = 0;
+    size_t levels = 0;
+    auto add_level = [&](const Amount& price, const Amount& volume) {
+      crc = crc_level_value(crc, price, pair_decimals);
+      crc = crc_level_value(crc, volume, lot_decimals);
+      return ++levels < checksum_depth;
+    };
+    asks.for_each(add_level);
+    levels = 0;
+    bids.for_each(add_level);
+    return crc;
+  });
+}
+
+Amount LeveledOrderBook::convert(Amount amount, bool reversed) const {
 
   // XBTC/USD 
   // symbol1=XBTC, symbol2=USD
@@ -41,20 +292,19 @@ __int128 LeveledOrderBook::estimate_conversion_from_1(__int128 amount) const {
   // bids - 1681800000000
   // zamenit BTX na USD znamena pouzit bids
 
-  const std::lock_guard<std::mutex> lock(update_mutex);
-  __int128 volume_consumed = 0;
-  __int128 received = 0;
-  auto level_it = bids.rbegin();
-  while (volume_consumed < amount && level_it != bids.rend()) {
-    __int128 price_at_level = level_it->first;
-    __int128 volume_at_level = level_it->second;
-    __int128 exchanging = std::min(volume_at_level, amount - volume_consumed);
-    volume_consumed = volume_consumed + exchanging;
-    received = received + exchanging * price_at_level / dec_power;
-    level_it++;
-  }
+  if (!is_valid())
+    return Amount();
+  return read_sides([&](const auto& asks, const auto& bids) {
+    return reversed ? convert_from_2(asks, amount) : convert_from_1(bids, amount);
+  });
+}
 
-  return received;
+Amount LeveledOrderBook::required(Amount target, bool reversed) const {
+  if (!is_valid())
+    return -Amount::from_raw(1);
+  return read_sides([&](const auto& asks, const auto& bids) {
+    return reversed ? required_from_2(asks, target) : required_from_1(bids, target);
+  });
 }
 
 // LeveledOrderBook& LeveledOrderBook::operator=(const LeveledOrderBook& other) {
@@ -66,53 +316,143 @@ __int128 LeveledOrderBook::estimate_conversion_from_1(__int128 amount) const {
 //   return *this;
 // }
 
+__int128 LeveledOrderBook::estimate_conversion_from_1(__int128 amount) const {
+  return convert(Amount::from_raw(amount), false).raw();
+}
 __int128 LeveledOrderBook::estimate_conversion_from_2(__int128 amount) const {
-  const std::lock_guard<std::mutex> lock(update_mutex);
-  __int128 volume_consumed = 0;
-  __int128 received = 0;
-  auto level_it = asks.begin();
-  while (volume_consumed < amount && level_it != asks.end()) {
-    __int128 price_at_level = level_it->first;
-    __int128 volume_at_level = level_it->second * price_at_level;
-    __int128 exchanging = std::min(volume_at_level, amount - volume_consumed);
-    volume_consumed = volume_consumed + exchanging;
-    received = received + exchanging * dec_power / price_at_level;
-    level_it++;
+  return convert(Amount::from_raw(amount), true).raw();
+}
+__int128 LeveledOrderBook::estimate_required_from_1(__int128 target) const {
+  return required(Amount::from_raw(target), false).raw();
+}
+__int128 LeveledOrderBook::estimate_required_from_2(__int128 target) const {
+  return required(Amount::from_raw(target), true).raw();
+}
+
+void LeveledOrderBook::estimate_conversions_from_1(std::span<const Amount> amounts, std::span<Amount> out) const {
+  if (!is_valid()) {
+    std::fill_n(out.begin(), amounts.size(), Amount());
+    return;
   }
+  read_sides([&](const auto&, const auto& bids) {
+    convert_batch_from_1(bids, amounts, out);
+    return true;
+  });
+}
 
-  return received;
+void LeveledOrderBook::estimate_conversions_from_2(std::span<const Amount> amounts, std::span<Amount> out) const {
+  if (!is_valid()) {
+    std::fill_n(out.begin(), amounts.size(), Amount());
+    return;
+  }
+  read_sides([&](const auto& asks, const auto&) {
+    convert_batch_from_2(asks, amounts, out);
+    return true;
+  });
+}
+
+void LeveledOrderBook::get_conversion_curve(bool from_symbol_2, std::vector<ConversionSegment>& segments) const {
+  if (!is_valid()) {
+    segments.clear();
+    return;
+  }
+  read_sides([&](const auto& asks, const auto& bids) {
+    segments.clear();
+    if (from_symbol_2) {
+      asks.for_each([&](const Amount& price, const Amount& volume) {
+        if (price.raw() <= 0)
+          return false;
+        segments.push_back({double(Amount::one) / double(price.raw()), volume.mul(price)});
+        return true;
+      });
+    } else {
+      bids.for_each([&](const Amount& price, const Amount& volume) {
+        segments.push_back({double(price.raw()) / double(Amount::one), volume});
+        return true;
+      });
+    }
+    return segments.size();
+  });
 }
 
 __int128 LeveledOrderBook::estimate_fee_from_1(__int128 amount) const {
-  return amount * 24 / 10000;
+  return fee(Amount::from_raw(amount), false).raw();
 }
 __int128 LeveledOrderBook::estimate_fee_from_2(__int128 amount) const {
-  return amount * 24 / 10000;
+  return fee(Amount::from_raw(amount), true).raw();
 }
 
 void LeveledOrderBook::update() {}
 
-void LeveledOrderBook::updateAskLevel(__int128 price, __int128 volume) {
-  const std::lock_guard<std::mutex> lock(update_mutex);
-  if (volume == 0) {
-    asks.erase(price);
-    return;
+void LeveledOrderBook::apply_updates(std::span<const LevelUpdate> updates, bool snapshot) {
+  write_sides([&](auto& asks, auto& bids) {
+    if (snapshot) {
+      asks.clear();
+      bids.clear();
+    }
+    for (const LevelUpdate& u : updates) {
+      if (u.side == BookSide::Ask)
+        asks.update(u.price, u.volume);
+      else
+        bids.update(u.price, u.volume);
+    }
+  });
+  if (snapshot) {
+    stale.store(false, std::memory_order_release);
+    valid.store(true, std::memory_order_release);
   }
+}
 
-  asks[price] = volume;
-  if (asks.size() > ob_depth) {
-    asks.erase(std::prev(asks.end()));
-  }
+void LeveledOrderBook::invalidate() {
+  valid.store(false, std::memory_order_release);
 }
-void LeveledOrderBook::updateBidLevel(__int128 price, __int128 volume) {
-  const std::lock_guard<std::mutex> lock(update_mutex);
-  if (volume == 0) {
-    bids.erase(price);
-    return;
-  }
 
-  bids[price] = volume;
-  if (bids.size() > ob_depth) {
-    bids.erase(bids.begin());
-  }
-}
\ No newline at end of file
+void LeveledOrderBook::restore(std::span<const LevelUpdate> levels) {
+  stale.store(true, std::memory_order_release);
+  write_sides([&](auto& asks, auto& bids) {
+    asks.clear();
+    bids.clear();
+    for (const LevelUpdate& u : levels) {
+      if (u.side == BookSide::Ask)
+        asks.update(u.price, u.volume);
+      else
+        bids.update(u.price, u.volume);
+    }
+  });
+  valid.store(true, std::memory_order_release);
+}
+
+void LeveledOrderBook::disable_checksum() {
+  checksum_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool LeveledOrderBook::get_levels(std::vector<LevelUpdate>& levels) const {
+  if (!is_valid())
+    return false;
+  const size_t first = levels.size();
+  read_sides([&](const auto& asks, const auto& bids) {
+    // A seqlock retry runs this again, drop what the torn pass appended.
+    levels.resize(first);
+    asks.for_each([&](const Amount& price, const Amount& volume) {
+      levels.push_back({BookSide::Ask, price, volume});
+      return true;
+    });
+    bids.for_each([&](const Amount& price, const Amount& volume) {
+      levels.push_back({BookSide::Bid, price, volume});
+      return true;
+    });
+    return true;
+  });
+  return true;
+}
+
+void LeveledOrderBook::updateAskLevel(Amount price, Amount volume) {
+  write_sides([&](auto& asks, auto&) {
+    asks.update(price, volume);
+  });
+}
+void LeveledOrderBook::updateBidLevel(Amount price, Amount volume) {
+  write_sides([&](auto&, auto& bids) {
+    bids.update(price, volume);
+  });
+}
@@ -26,6 +26,12 @@ __int128 NullOrderBook::estimate_conversion_from_1(__int128 amount) const {
 __int128 NullOrderBook::estimate_conversion_from_2(__int128 amount) const {
   return 0;
 };
+__int128 NullOrderBook::estimate_required_from_1(__int128 target) const {
+  return -1;
+};
+__int128 NullOrderBook::estimate_required_from_2(__int128 target) const {
+  return -1;
+};
 __int128 NullOrderBook::estimate_fee_from_1(__int128 amount) const {
   return 1LL << 58;
 };
@@ -37,30 +43,32 @@ void NullOrderBook::update() {}
 std::string NullOrderBook::print() const { return "Non-existing pair"; }
 
 bool operator<(const Symbol& first, const Symbol& second) {
-  return first.get_symbol() < second.get_symbol();
+  return first._id < second._id;
 }
 
 bool operator==(const Symbol& first, const Symbol& second) {
-  return first.get_symbol() == second.get_symbol();
+  return first._id == second._id;
 }
 
 
-Symbol::Symbol(const std::string& symbol, const std::string& name, const std::string& exchange) :
-    _name(name), _symbol(symbol), _exchange(exchange) {}
-Symbol::Symbol(const std::string& symbol, const std::string& exchange) :
-    _name(), _symbol(symbol), _exchange(exchange) {}
+Symbol::Symbol(size_t id, const std::string& symbol, const std::string& name, const std::string& exchange) :
+    _name(name), _symbol(symbol), _exchange(exchange), _id(id) {}
+Symbol::Symbol(size_t id, const std::string& symbol, const std::string& exchange) :
+    _name(), _symbol(symbol), _exchange(exchange), _id(id) {}
 Symbol::Symbol(Symbol&& other) {
   _name = std::move(other._name);
   _symbol = std::move(other._symbol);
   _exchange = std::move(other._exchange);
+  _id = other._id;
   _reference_rate_estimate = other._reference_rate_estimate;
 }
 
 const std::string& Symbol::get_symbol() const { return _symbol; }
 const std::string& Symbol::get_name() const { return _name; }
 const std::string& Symbol::get_exchange() const { return _exchange; }
-__int128 Symbol::get_reference_rate_estimate() const { return _reference_rate_estimate; }
-void Symbol::set_reference_rate_estimate(__int128 reference_rate_estimate) const {
+size_t Symbol::get_id() const { return _id; }
+Amount Symbol::get_reference_rate_estimate() const { return _reference_rate_estimate; }
+void Symbol::set_reference_rate_estimate(Amount reference_rate_estimate) const {
   _reference_rate_estimate = reference_rate_estimate;
 }
 
@@ -69,6 +77,8 @@ const Symbol& ReverseOrderBook::get_symbol_1() const { return _orig.get_symbol_2
 const Symbol& ReverseOrderBook::get_symbol_2() const { return _orig.get_symbol_1();};
 __int128 ReverseOrderBook::estimate_conversion_from_1(__int128 amount) const { return _orig.estimate_conversion_from_2(amount);};
 __int128 ReverseOrderBook::estimate_conversion_from_2(__int128 amount) const { return _orig.estimate_conversion_from_1(amount);};
+__int128 ReverseOrderBook::estimate_required_from_1(__int128 target) const { return _orig.estimate_required_from_2(target);};
+__int128 ReverseOrderBook::estimate_required_from_2(__int128 target) const { return _orig.estimate_required_from_1(target);};
 __int128 ReverseOrderBook::estimate_fee_from_1(__int128 amount) const { return _orig.estimate_fee_from_2(amount);};
 __int128 ReverseOrderBook::estimate_fee_from_2(__int128 amount) const { return _orig.estimate_fee_from_1(amount);};
 void ReverseOrderBook::update() {}
@@ -83,7 +93,7 @@ SymbolFactory& SymbolFactory::get_factory() {
 const Symbol& SymbolFactory::add_symbol(const std::string& symbol, const std::string& name, const std::string& exchange) {
   size_t length = _symbols.size();
   _symbol_indices.insert({std::make_pair(symbol, exchange), length});
-  _symbols.push_back(Symbol(symbol, name, exchange));
+  _symbols.push_back(Symbol(length, symbol, name, exchange));
 
   return _symbols[length];
 }
@@ -91,7 +101,7 @@ const Symbol& SymbolFactory::add_symbol(const std::string& symbol, const std::st
 const Symbol& SymbolFactory::add_symbol(const std::string& symbol, const std::string& exchange) {
   size_t length = _symbols.size();
   _symbol_indices.insert({std::make_pair(symbol, exchange), length});
-  _symbols.push_back(Symbol(symbol, exchange));
+  _symbols.push_back(Symbol(length, symbol, exchange));
 
   return _symbols[length];
 }
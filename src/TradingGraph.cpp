@@ -0,0 +1,35 @@
+#include <algorithm>
+#include "TradingGraph.hpp"
+
+TradingGraph::TradingGraph(std::span<const BookHandle> handles) {
+  auto add_node = [this](const Symbol& symbol) {
+    size_t id = symbol.get_id();
+    if (id >= node_by_symbol_id.size())
+      node_by_symbol_id.resize(id + 1, no_node);
+    if (node_by_symbol_id[id] == no_node) {
+      node_by_symbol_id[id] = nodes.size();
+      nodes.push_back(symbol);
+    }
+    return node_by_symbol_id[id];
+  };
+
+  std::vector<std::pair<uint32_t, Edge>> sources;
+  sources.reserve(handles.size());
+  for (const BookHandle& handle : handles) {
+    uint32_t from = add_node(handle.generic->get_symbol_1());
+    uint32_t to = add_node(handle.generic->get_symbol_2());
+    sources.push_back({from, {to, handle}});
+  }
+  std::sort(sources.begin(), sources.end(), [](const auto& a, const auto& b) {
+    return a.first != b.first ? a.first < b.first : a.second.target < b.second.target;
+  });
+
+  offsets.assign(nodes.size() + 1, 0);
+  edges.reserve(sources.size());
+  for (const auto& [from, edge] : sources) {
+    offsets[from + 1]++;
+    edges.push_back(edge);
+  }
+  for (size_t node = 0; node < nodes.size(); node++)
+    offsets[node + 1] += offsets[node];
+}
@@ -0,0 +1,23 @@
+#include "TradingPairTable.hpp"
+
+void TradingPairTable::reset(size_t symbol_count) {
+  this->symbol_count = symbol_count;
+  slots.assign(symbol_count * symbol_count, no_slot);
+  handles.clear();
+}
+
+void TradingPairTable::add(const LeveledOrderBook& book, const ReverseOrderBook& reverse) {
+  size_t id1 = book.get_symbol_1().get_id(), id2 = book.get_symbol_2().get_id();
+  if (id1 >= symbol_count || id2 >= symbol_count)
+    return;
+
+  slots[id1 * symbol_count + id2] = handles.size();
+  handles.push_back({&book, false, &book});
+  slots[id2 * symbol_count + id1] = handles.size();
+  handles.push_back({&book, true, &reverse});
+}
+
+void estimate_conversions(std::span<const BookHandle> books, Amount amount, std::span<Amount> out) {
+  for (size_t i = 0; i < books.size(); i++)
+    out[i] = books[i].convert(amount);
+}
@@ -9,16 +9,21 @@
 #include <Poco/HMACEngine.h>
 #include <Poco/SHA2Engine.h>
 #include <Poco/Base64Encoder.h>
+#include <Poco/Timespan.h>
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <set>
 #include <map>
 #include <numeric>
 #include <thread>
 #include <chrono>
+#include <charconv>
 
 #include "LeveledOrderBook.hpp"
 #include "connector/input/Kraken.hpp"
+#include "connector/input/WsMessageReader.hpp"
 #include "Utils.hpp"
 #include "Exceptions.hpp"
 
@@ -33,7 +38,13 @@ static const std::map<std::string, std::string> rewrite_assets {
 };
 
 static const std::string base_asset("USD");
+// Pairs per bulk Ticker request.
+static const size_t ticker_pairs_per_request = 50;
 static std::string exchange_string("kraken");
+// Book depths the feed accepts, ascending.
+static const size_t book_depths[] = {10, 25, 100, 500, 1000};
+// Book feed connections this long without a message are reconnected.
+static const std::chrono::seconds feed_silence_limit(60);
 
 std::string sign_message(const std::string& message, const std::string& secret) {
   Poco::HMACEngine<Poco::SHA2Engine512> hmac(secret);
@@ -57,6 +68,12 @@ std::string sha256(const std::string& message) {
   return ss.str();
 }
 
+std::string book_subscription_message(const std::string& event, const std::string& pairs, size_t depth) {
+  return "{ \"event\": \"" + event + "\", \"pair\": ["
+          + pairs + "], \"subscription\": { \"name\": \"book\", \"depth\": "
+          + std::to_string(depth) + "} }";
+}
+
 const std::string& rewrite_symbol(const std::string& orig) {
   const auto& it = rewrite_assets.find(orig);
   if (it != rewrite_assets.end())
@@ -66,9 +83,68 @@ const std::string& rewrite_symbol(const std::string& orig) {
 } //namespace
 
 
-KrakenExchange::KrakenExchange() : logger(Poco::Logger::root().get("Kraken")) {
+KrakenExchange::KrakenExchange(bool offline) : logger(Poco::Logger::root().get("Kraken")) {
  APIKey = config->getString("Kraken.APIKey");
  PrivateKey = config->getString("Kraken.PrivateKey");
+ book_depth = config->getInt("Kraken.OBDepth", default_book_depth);
+ // Any other depth is refused by the feed, take the next one up.
+ const size_t* supported_depth = std::lower_bound(std::begin(book_depths), std::end(book_depths), book_depth);
+ if (supported_depth == std::end(book_depths))
+   supported_depth--;
+ if (*supported_depth != book_depth) {
+   poco_warning(logger, "Kraken.OBDepth " + std::to_string(book_depth) + " is not a book depth Kraken offers, using "
+                        + std::to_string(*supported_depth));
+   book_depth = *supported_depth;
+ }
+ book_storage = config->getString("Kraken.OBStorage", "flat") == "map" ? BookStorage::Map : BookStorage::Flat;
+
+ warm_cache_path = config->getString("Kraken.WarmCache", "");
+ warm_cache_interval = std::chrono::seconds(config->getInt("Kraken.WarmCacheInterval", 60));
+ warm_cache_max_age = std::chrono::seconds(config->getInt("Kraken.WarmCacheMaxAge", 24 * 3600));
+
+ // Kraken.FeedCpus: comma separated CPUs the shards are pinned to, in shard order.
+ const size_t shard_count = offline ? 1 : std::max(1, config->getInt("Kraken.FeedShards", 1));
+ std::vector<int> cpus;
+ std::stringstream cpu_list(config->getString("Kraken.FeedCpus", ""));
+ for (std::string cpu; std::getline(cpu_list, cpu, ',');) {
+   if (!cpu.empty())
+     cpus.push_back(std::stoi(cpu));
+ }
+ for (size_t i = 0; i < shard_count; i++)
+   shards.push_back(std::make_unique<KrakenFeedShard>(i, i < cpus.size() ? cpus[i] : -1));
+ rebalance_interval = std::chrono::seconds(config->getInt("Kraken.FeedRebalanceInterval", 60));
+ if (offline)
+   return;
+
+ HttpsSessionPool::Options rest_options;
+ rest_options.host = https_host;
+ rest_options.size = config->getInt("Kraken.RestSessions", 2);
+ rest_options.ping_interval = std::chrono::seconds(config->getInt("Kraken.RestPingInterval", 15));
+ rest_sessions = std::make_unique<HttpsSessionPool>(rest_options);
+ order_workers = std::make_unique<RequestWorkers>(rest_options.size);
+
+ if (config->getString("Kraken.OrderEntry", "rest") == "ws") {
+   KrakenWsTrading::Options ws_options;
+   ws_options.host = config->getString("Kraken.OrderEntryHost", ws_auth_host);
+   ws_options.port = config->getInt("Kraken.OrderEntryPort", 443);
+   ws_options.secure = config->getBool("Kraken.OrderEntrySecure", true);
+   ws_trading = std::make_unique<KrakenWsTrading>(ws_options, [this] { return fetch_ws_token(); });
+ }
+
+ std::string record_path = config->getString("Kraken.Record", "");
+ if (!record_path.empty()) {
+   MarketRecorder::Options record_options;
+   record_options.path = record_path;
+   record_options.format = config->getString("Kraken.RecordFormat", "raw") == "columnar" ? RecordingFormat::Columnar
+                                                                                          : RecordingFormat::Raw;
+   record_options.rotate_bytes = size_t(config->getInt("Kraken.RecordRotateMB", 256)) << 20;
+   record_options.max_files = config->getInt("Kraken.RecordMaxFiles", 0);
+   try {
+     recorder = std::make_unique<MarketRecorder>(record_options);
+   } catch (Poco::Exception& e) {
+     poco_error(logger, "Recording disabled: " + e.displayText());
+   }
+ }
 };
 
 std::vector<std::reference_wrapper<const Symbol>> KrakenExchange::get_all_symbols() {
@@ -92,56 +168,109 @@ std::map<std::reference_wrapper<const Symbol>, std::set<std::reference_wrapper<c
 }
 
 bool KrakenExchange::has_trading_pair(const Symbol& symbol1, const Symbol& symbol2) {
-  return (trading_pair_resolver.count({symbol1.get_symbol(), symbol2.get_symbol()}) > 0);
+  const BookHandle* handle = pair_table.find(symbol1, symbol2);
+  return handle != nullptr && !handle->reversed;
+}
+
+const TradingGraph& KrakenExchange::get_trading_graph() {
+  return trading_graph;
+}
+
+void KrakenExchange::rebuild_pair_index() {
+  pair_table.reset(SymbolFactory::get_factory().count());
+  for (const auto& [name, ob] : trading_pairs)
+    pair_table.add(ob, reverse_order_books.find(name)->second);
+  trading_graph = TradingGraph(pair_table.get_handles());
+}
+
+bool KrakenExchange::wait_for_changes(std::vector<const GenericOrderBook*>& changed, std::chrono::milliseconds timeout) {
+  changed.clear();
+  if (!book_changes.wait(changed_books, timeout))
+    return false;
+  changed.insert(changed.end(), changed_books.begin(), changed_books.end());
+  return true;
 }
 
 void KrakenExchange::start_connection_async() {
-  std::thread init(&KrakenExchange::fetch_trading_pairs, this);
-  init.join();
-  std::thread go(&KrakenExchange::process_ws, this);
-  go.detach();
+  std::thread init([this] {
+    bool warm = load_warm_cache();
+    if (!warm)
+      add_trading_pairs(fetch_asset_pairs());
+    // The feed only needs the pair names, books fill while the rates load.
+    assign_pairs_to_shards();
+    for (auto& shard : shards) {
+      std::thread go(&KrakenExchange::process_ws, this, std::ref(*shard));
+      go.detach();
+    }
+    if (shards.size() > 1 && rebalance_interval.count() > 0) {
+      std::thread rebalancer(&KrakenExchange::rebalance_shards_periodically, this);
+      rebalancer.detach();
+    }
+    if (ws_trading)
+      ws_trading->start();
+    if (warm) {
+      try {
+        validate_trading_pairs(fetch_asset_pairs());
+      } catch (Poco::Exception& e) {
+        poco_warning(logger, "Cannot validate cached pairs, keeping them: " + e.displayText());
+      }
+    }
+    fetch_reference_rates();
+    initialized = true;
+    poco_notice(logger, "Pairs and reference rates loaded");
+    if (!warm_cache_path.empty()) {
+      std::thread saver(&KrakenExchange::save_warm_cache_periodically, this);
+      saver.detach();
+    }
+  });
+  init.detach();
 }
 
 const GenericOrderBook& KrakenExchange::get_order_book(const Symbol& symbol1, const Symbol& symbol2) {
-  if (trading_pair_resolver.count({symbol1.get_symbol(), symbol2.get_symbol()}) > 0) {
-    const std::string pair_name = trading_pair_resolver[{symbol1.get_symbol(), symbol2.get_symbol()}];
-    return trading_pairs.find(pair_name)->second;
-  }
-    
-  if (trading_pair_resolver.count({symbol2.get_symbol(), symbol1.get_symbol()}) > 0) {
-    const std::string pair_name = trading_pair_resolver[{symbol2.get_symbol(), symbol1.get_symbol()}];
-    return reverse_order_books.find(pair_name)->second;
-  }
+  const BookHandle* handle = pair_table.find(symbol1, symbol2);
+  if (handle != nullptr)
+    return *handle->generic;
   throw new not_found_exception("unknown ob");
 }
 
+Poco::JSON::Object::Ptr KrakenExchange::send_public_get_request(const std::string& url) {
+  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, url, Poco::Net::HTTPMessage::HTTP_1_1);
+  std::string response_content;
+  rest_sessions->send(request, "", response_content);
+
+  Poco::JSON::Parser parser;
+  Poco::Dynamic::Var result = parser.parse(response_content);
+  return result.extract<Poco::JSON::Object::Ptr>();
+}
+
 Poco::JSON::Object::Ptr KrakenExchange::send_authenticated_post_request(const std::string& url, std::string content) {
-  Poco::Net::HTTPSClientSession session(https_host);
-  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, url);
+  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, url, Poco::Net::HTTPMessage::HTTP_1_1);
   request.setContentType("application/x-www-form-urlencoded");
   request.set("API-Key", APIKey);
-  std::string nonce = std::to_string(time(nullptr));
+  std::string nonce = std::to_string(nonces.next());
   content = "nonce=" + nonce + "&" + content;
   request.set("API-Sign", sign_message(url + sha256(nonce + content), PrivateKey));
-  session.sendRequest(request) << content; //pair=XBTUSD&type=buy&ordertype=market&volume=1
-  Poco::Net::HTTPResponse response;
-  std::istream &rs = session.receiveResponse(response);
+  //pair=XBTUSD&type=buy&ordertype=market&volume=1
+  std::string response_content;
+  Poco::Net::HTTPResponse::HTTPStatus status = rest_sessions->send(request, content, response_content);
 
-  if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK) {
-    std::string response_content;
-    Poco::StreamCopier::copyToString(rs, response_content);
-    throw order_failed_exception(response.getStatus(), response_content);
-  }
+  if (status != Poco::Net::HTTPResponse::HTTP_OK)
+    throw order_failed_exception(status, response_content);
   Poco::JSON::Parser parser;
-  Poco::Dynamic::Var result = parser.parse(rs);
-  Poco::JSON::Object::Ptr object = result.extract<Poco::JSON::Object::Ptr>();
-
-  return object->get("result").extract<Poco::JSON::Object::Ptr>();
+  Poco::Dynamic::Var result = parser.parse(response_content);
+  return result.extract<Poco::JSON::Object::Ptr>();
 }
 
 
 
-void KrakenExchange::process_ws() {
+void KrakenExchange::process_ws(KrakenFeedShard& shard) {
+  const std::string shard_name = "Feed shard " + std::to_string(shard.index);
+  if (shard.cpu >= 0) {
+    if (pin_thread_to_cpu(shard.cpu))
+      poco_notice(logger, shard_name + " pinned to CPU " + std::to_string(shard.cpu));
+    else
+      poco_warning(logger, "Cannot pin " + shard_name + " to CPU " + std::to_string(shard.cpu));
+  }
   while (true) try {
   // Set up HTTP client and request
   Poco::Net::HTTPSClientSession session(ws_host);
@@ -150,105 +279,81 @@ void KrakenExchange::process_ws() {
 
   // Set up WebSocket and connect
   Poco::Net::WebSocket ws(session, request, response);
-  poco_notice(logger, "Connected to Kraken WebSockets API");
-
+  poco_notice(logger, shard_name + " connected to Kraken WebSockets API");
 
-  std::string pairs = "";
-  pairs = std::accumulate(
-    std::next(trading_pairs.begin()),
-    trading_pairs.end(),
-    "\"" + trading_pairs.begin()->first + "\"",
-    [](std::string a, const auto& b) -> std::string {
-        return a + ", \"" + b.first + "\"";
-    }
-  );
+  process_handovers(shard, nullptr);
+  std::vector<std::string> shard_pairs;
+  {
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    shard_pairs = shard.pairs;
+  }
+  if (!shard_pairs.empty()) {
+    std::string pairs = std::accumulate(
+      std::next(shard_pairs.begin()),
+      shard_pairs.end(),
+      "\"" + shard_pairs.front() + "\"",
+      [](std::string a, const std::string& b) -> std::string {
+          return a + ", \"" + b + "\"";
+      }
+    );
 
-  std::string subscribeMessage = "{ \"event\": \"subscribe\", \"pair\": [" 
-          + pairs + "], \"subscription\": { \"name\": \"book\", \"depth\": "
-          + std::to_string(config->getInt("Kraken.OBDepth")) + "} }";
-  ws.sendFrame(subscribeMessage.data(), subscribeMessage.size());
-  poco_notice(logger, "Subscribed to trade channel for " + pairs + " pairs");
+    std::string subscribeMessage = book_subscription_message("subscribe", pairs, book_depth);
+    ws.sendFrame(subscribeMessage.data(), subscribeMessage.size());
+    poco_notice(logger, shard_name + " subscribed to trade channel for " + pairs + " pairs");
+  }
 
   // Receive and process messages from the WebSocket
-  char buffer[8192];
-  int flags;
-  int n;
-  do
+  KrakenBookFrame frame;
+  WsMessageReader messages;
+  auto last_message = std::chrono::steady_clock::now();
+  while (true)
   {
-      n = ws.receiveFrame(buffer, sizeof(buffer), flags);
-      if (n > 0 && (flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) == Poco::Net::WebSocket::FRAME_OP_TEXT)
+      if (shard.handovers_pending.load(std::memory_order_acquire))
+        process_handovers(shard, &ws);
+      // Quiet shards still look at their handovers every second. Waiting here
+      // rather than timing out the receive, which cannot resume a frame it
+      // timed out in the middle of. available() covers bytes TLS has already
+      // decrypted, which the socket does not signal.
+      if (ws.available() == 0 && !ws.poll(Poco::Timespan(1, 0), Poco::Net::Socket::SELECT_READ)) {
+        // Subscribed feeds send heartbeats every second, silence means a dead connection.
+        if (std::chrono::steady_clock::now() - last_message < feed_silence_limit)
+          continue;
+        poco_warning(logger, shard_name + " received nothing for " + std::to_string(feed_silence_limit.count())
+                             + " s, reconnecting");
+        break;
+      }
+      if (!messages.receive(ws))
+        break;
+      last_message = std::chrono::steady_clock::now();
+      if (messages.opcode() == Poco::Net::WebSocket::FRAME_OP_TEXT)
       {
-          buffer[n] = 0;
-          // Parse message as JSON
-          try {
-            Poco::JSON::Parser parser;
-            Poco::Dynamic::Var result = parser.parse(buffer);
-
-            if (result.isArray()) {
-              Poco::JSON::Array::Ptr arr = result.extract<Poco::JSON::Array::Ptr>();
-              size_t count = arr->size();
-              std::string pair = arr->getElement<std::string>(count-1);
-              LeveledOrderBook& ob = trading_pairs.find(pair)->second;
-
-              for (int i=1; i<count-2; i++) {
-                Poco::JSON::Object::Ptr changeObject = arr->getObject(i);
-                for (const std::string& el : {"a", "as"}) {
-                  if (changeObject->has(el)) {
-                    Poco::JSON::Array::Ptr askLevelsArr = changeObject->getArray(el);
-                    for (int i=0; i<askLevelsArr->size(); i++) {
-                      Poco::JSON::Array::Ptr askLevelArr = askLevelsArr->getArray(i);
-                      std::string level = askLevelArr->getElement<std::string>(0);
-                      std::string volume = askLevelArr->getElement<std::string>(1);
-
-                      // get OB, fill level
-                      ob.updateAskLevel(
-                        uint64_t(stod(level) * dec_power), 
-                        uint64_t(stod(volume) * dec_power)
-                      );
-                    }
-                  }
-                }
-
-                for (const std::string& el : {"b", "bs"}) {
-                  if (changeObject->has(el)) {
-                    Poco::JSON::Array::Ptr bidLevelsArr = changeObject->getArray(el);
-                    for (int i=0; i<bidLevelsArr->size(); i++) {
-                      Poco::JSON::Array::Ptr bidLevelArr = bidLevelsArr->getArray(i);
-                      std::string level = bidLevelArr->getElement<std::string>(0);
-                      std::string volume = bidLevelArr->getElement<std::string>(1);
-                      // get OB, fill level
-                      ob.updateBidLevel(
-                        uint64_t(stod(level) * dec_power), 
-                        uint64_t(stod(volume) * dec_power)
-                      );
-                    }
-                  }
-                }
-              }
-            } else {
-              Poco::JSON::Object::Ptr object = result.extract<Poco::JSON::Object::Ptr>();
-              // Print message if it is a trade update
-              if (object->has("event"))
-              {
-                // Ignore these messages for now, maybe use the confirmations later
-                //std::cout << "Received event update: " << buffer << std::endl;
-              } else {
-                poco_warning(logger, "Unknown message: " + std::string(buffer));
-              }
-            }
-          } catch (Poco::Exception& e) {
-            poco_error(logger, "Cannot handle this frame " + std::string(buffer) + " - error " + e.displayText());
+          shard.frame_trace_ns = trace_now();
+          if (recorder) {
+            shard.frame_receive_ns = MarketRecorder::now_ns();
+            const std::lock_guard<std::mutex> lock(recorder_mutex);
+            recorder->record_frame(shard.frame_receive_ns, messages.data(), messages.size());
           }
+          handle_frame(shard, messages.data(), messages.size(), frame);
+          if (!shard.resync_pairs.empty())
+            send_resyncs(shard, ws);
       }
-  } while (n > 0 && (flags & Poco::Net::WebSocket::FRAME_OP_BITMASK) != Poco::Net::WebSocket::FRAME_OP_CLOSE);
+  }
   ws.close();
-  poco_notice(logger, "Disconnected from Kraken WebSockets API");
+  poco_notice(logger, shard_name + " disconnected from Kraken WebSockets API");
+  invalidate_shard_books(shard);
 
   } catch (Poco::Net::SSLConnectionUnexpectedlyClosedException& e) {
     poco_warning(logger, std::string("Caught SSL exception, restarting session ") + e.what());
+    invalidate_shard_books(shard);
   }
   catch (Poco::TimeoutException& e) {
     poco_warning(logger, std::string("Caught SSL exception, restarting session ") + e.what());
+    invalidate_shard_books(shard);
+  }
+  catch (Poco::Exception& e) {
+    poco_warning(logger, shard_name + " connection failed, restarting session: " + e.displayText());
+    invalidate_shard_books(shard);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
   }
   // Close WebSocket
   
@@ -256,49 +361,260 @@ void KrakenExchange::process_ws() {
 }
 
 
-uint64_t KrakenExchange::try_fetch_reference_rate(const std::string& pair_name) {
-  poco_information(logger, "Trying to get ticker for pair " + pair_name);
-  Poco::Net::HTTPSClientSession session(https_host);
-  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/0/public/Ticker?pair=" + pair_name);
-  session.sendRequest(request);
-  Poco::Net::HTTPResponse response;
-  std::istream& responseStream = session.receiveResponse(response);
+bool KrakenExchange::handle_frame(KrakenFeedShard& shard, const char* data, size_t size, KrakenBookFrame& frame) {
+  if (parse_kraken_book_frame(data, size, frame)) {
+    shard.frame_parsed_ns = trace_now();
+    trace_span(TraceSpan::Parse, shard.frame_trace_ns, shard.frame_parsed_ns);
+    apply_book_frame(shard, frame);
+    return true;
+  }
+  // Parse message as JSON
+  try {
+    Poco::JSON::Parser parser;
+    Poco::Dynamic::Var result = parser.parse(std::string(data, size));
+
+    if (result.isArray()) {
+      poco_warning(logger, "Unhandled channel message: " + std::string(data, size));
+    } else {
+      Poco::JSON::Object::Ptr object = result.extract<Poco::JSON::Object::Ptr>();
+      // Print message if it is a trade update
+      if (object->has("event"))
+      {
+        // Ignore these messages for now, maybe use the confirmations later
+        //std::cout << "Received event update: " << buffer << std::endl;
+      } else {
+        poco_warning(logger, "Unknown message: " + std::string(data, size));
+      }
+    }
+  } catch (Poco::Exception& e) {
+    poco_error(logger, "Cannot handle this frame " + std::string(data, size) + " - error " + e.displayText());
+  }
+  return false;
+}
 
-  Poco::JSON::Parser parser;
-  Poco::Dynamic::Var result = parser.parse(responseStream);
-  Poco::JSON::Object::Ptr object = result.extract<Poco::JSON::Object::Ptr>();
+void KrakenExchange::apply_book_frame(KrakenFeedShard& shard, const KrakenBookFrame& frame) {
+  auto ob_it = trading_pairs.find(frame.pair);
+  if (ob_it == trading_pairs.end()) {
+    poco_warning(logger, "Book update for unknown pair " + std::string(frame.pair));
+    return;
+  }
+  LeveledOrderBook& ob = ob_it->second;
+  // Late frames of a pair handed to another shard.
+  if (ob.writer.load(std::memory_order_relaxed) != shard.index)
+    return;
+  // Deltas for a book that failed its checksum are useless until the fresh snapshot.
+  if (!frame.snapshot && !ob.is_valid())
+    return;
+
+  std::vector<LevelUpdate>& level_updates = shard.level_updates;
+  level_updates.clear();
+  for (const KrakenBookLevel& level : frame.levels) {
+    LevelUpdate update{level.side};
+    if (!Amount::parse(level.price, update.price) || !Amount::parse(level.volume, update.volume)) {
+      poco_warning(logger, "Malformed level " + std::string(level.price) + " / " + std::string(level.volume) + " for " + ob_it->first);
+      continue;
+    }
+    level_updates.push_back(update);
+  }
+  if (recorder) {
+    const std::lock_guard<std::mutex> lock(recorder_mutex);
+    recorder->record_levels(shard.frame_receive_ns, frame.pair, frame.snapshot, level_updates);
+  }
+  ob.apply_updates(level_updates, frame.snapshot);
+
+  if (!frame.checksum.empty() && ob.supports_checksum()) {
+    uint32_t expected = 0;
+    std::from_chars(frame.checksum.data(), frame.checksum.data() + frame.checksum.size(), expected);
+    if (ob.checksum() != expected) {
+      poco_warning(logger, "Checksum mismatch for " + ob_it->first + ", requesting a new snapshot");
+      ob.invalidate();
+      shard.resync_pairs.push_back(ob_it->first);
+    }
+  }
+  trace_book_update(shard, ob);
+  book_changes.push(ob);
+}
 
-  if (object->has("result")) {
+void KrakenExchange::trace_book_update(KrakenFeedShard& shard, LeveledOrderBook& ob) {
+  if constexpr (latency_trace_enabled) {
+    const uint64_t updated = trace_now();
+    trace_span(TraceSpan::Apply, shard.frame_parsed_ns, updated);
+    ob.trace_received_ns.store(shard.frame_trace_ns, std::memory_order_relaxed);
+    ob.trace_updated_ns.store(updated, std::memory_order_relaxed);
+  }
+}
 
-    Poco::JSON::Object::Ptr resultObject = object->get("result").extract<Poco::JSON::Object::Ptr>();
-    Poco::DynamicStruct ds = *resultObject;
-    std::string svalue = (ds.begin()->second)["p"][0];
-    
-    double value = std::stod(svalue);
-    long rv = ((double)dec_power * value);
-    poco_information(logger, " - found price of " + svalue + "(" + std::to_string(rv) + ")");
-    return rv;
+void KrakenExchange::send_resyncs(KrakenFeedShard& shard, Poco::Net::WebSocket& ws) {
+  for (const std::string& pair : shard.resync_pairs) {
+    std::string unsubscribeMessage = book_subscription_message("unsubscribe", "\"" + pair + "\"", book_depth);
+    std::string subscribeMessage = book_subscription_message("subscribe", "\"" + pair + "\"", book_depth);
+    ws.sendFrame(unsubscribeMessage.data(), unsubscribeMessage.size());
+    ws.sendFrame(subscribeMessage.data(), subscribeMessage.size());
   }
+  shard.resync_pairs.clear();
+}
 
-  poco_information(logger, " - ticker not found");
-  return 0;
+void KrakenExchange::invalidate_shard_books(const KrakenFeedShard& shard) {
+  for (auto& [name, ob] : trading_pairs) {
+    if (ob.writer.load(std::memory_order_relaxed) == shard.index)
+      ob.invalidate();
+  }
 }
 
-void KrakenExchange::fetch_trading_pairs() {
-  SymbolFactory& symbol_factory = SymbolFactory::get_factory();
+void KrakenExchange::assign_pairs_to_shards() {
+  size_t i = 0;
+  for (auto& [name, ob] : trading_pairs) {
+    KrakenFeedShard& shard = *shards[i++ % shards.size()];
+    ob.writer.store(shard.index, std::memory_order_relaxed);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.pairs.push_back(name);
+  }
+}
 
-  Poco::Net::HTTPSClientSession session(https_host);
-  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/0/public/AssetPairs");
-  session.sendRequest(request);
-  Poco::Net::HTTPResponse response;
-  std::istream& responseStream = session.receiveResponse(response);
+void KrakenExchange::process_handovers(KrakenFeedShard& shard, Poco::Net::WebSocket* ws) {
+  std::vector<std::pair<std::string, uint32_t>> releases;
+  std::vector<std::string> acquisitions;
+  {
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    releases.swap(shard.releases);
+    acquisitions.swap(shard.acquisitions);
+    shard.handovers_pending.store(false, std::memory_order_relaxed);
+  }
+  for (const auto& [pair, to] : releases) {
+    LeveledOrderBook& ob = trading_pairs.find(pair)->second;
+    // Posted again while the first move was still under way.
+    if (ob.writer.load(std::memory_order_relaxed) != shard.index)
+      continue;
+    ob.writer.store(no_writer, std::memory_order_relaxed);
+    ob.invalidate();
+    book_changes.push(ob);
+    if (ws != nullptr) {
+      std::string unsubscribeMessage = book_subscription_message("unsubscribe", "\"" + pair + "\"", book_depth);
+      ws->sendFrame(unsubscribeMessage.data(), unsubscribeMessage.size());
+    }
+    {
+      const std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.pairs.erase(std::find(shard.pairs.begin(), shard.pairs.end(), pair));
+    }
+    KrakenFeedShard& target = *shards[to];
+    const std::lock_guard<std::mutex> lock(target.mutex);
+    target.acquisitions.push_back(pair);
+    target.handovers_pending.store(true, std::memory_order_release);
+  }
+  for (const std::string& pair : acquisitions) {
+    trading_pairs.find(pair)->second.writer.store(shard.index, std::memory_order_relaxed);
+    {
+      const std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.pairs.push_back(pair);
+    }
+    if (ws != nullptr) {
+      std::string subscribeMessage = book_subscription_message("subscribe", "\"" + pair + "\"", book_depth);
+      ws->sendFrame(subscribeMessage.data(), subscribeMessage.size());
+    }
+  }
+}
 
-  Poco::JSON::Parser parser;
-  Poco::Dynamic::Var result = parser.parse(responseStream);
-  Poco::JSON::Object::Ptr object = result.extract<Poco::JSON::Object::Ptr>();
+void KrakenExchange::rebalance_shards_periodically() {
+  std::vector<LeveledOrderBook*> books;
+  std::vector<std::string> names;
+  for (auto& [name, ob] : trading_pairs) {
+    books.push_back(&ob);
+    names.push_back(name);
+  }
+  // Every applied frame bumps the book generation.
+  std::vector<uint64_t> generations(books.size()), rates(books.size());
+  std::vector<uint32_t> writers(books.size());
+  for (size_t i = 0; i < books.size(); i++)
+    generations[i] = books[i]->get_generation();
+  while (true) {
+    std::this_thread::sleep_for(rebalance_interval);
+    for (size_t i = 0; i < books.size(); i++) {
+      const uint64_t generation = books[i]->get_generation();
+      rates[i] = generation - generations[i];
+      generations[i] = generation;
+      writers[i] = books[i]->writer.load(std::memory_order_relaxed);
+    }
+    // A resubscription costs a snapshot and leaves the book invalid for a round
+    // trip, so only clear imbalances are fixed and a few pairs at a time.
+    std::vector<ShardMove> moves = plan_shard_moves(rates, writers, shards.size(), 8, 0.2);
+    for (const ShardMove& move : moves) {
+      poco_information(logger, "Moving " + names[move.pair] + " (" + std::to_string(rates[move.pair]) + " frames) from feed shard "
+                               + std::to_string(move.from) + " to " + std::to_string(move.to));
+      KrakenFeedShard& from = *shards[move.from];
+      const std::lock_guard<std::mutex> lock(from.mutex);
+      from.releases.push_back({names[move.pair], move.to});
+      from.handovers_pending.store(true, std::memory_order_release);
+    }
+  }
+}
+
+void KrakenExchange::fetch_reference_rates() {
+  struct Quote {
+    const Symbol& symbol;
+    // True for SYM/USD, whose price is USD per SYM.
+    bool usd_quoted;
+  };
+  const Symbol& usd = SymbolFactory::get_factory().get_symbol(base_asset, base_asset, exchange_string);
+  std::map<std::string, Quote> quotes;
+  for (const Symbol& s : all_symbols) {
+    if (s.get_symbol() == base_asset) {
+      s.set_reference_rate_estimate(Amount::from_integer(1));
+      continue;
+    }
+    const BookHandle* handle = pair_table.find(s, usd);
+    if (handle == nullptr) {
+      poco_information(logger, "No USD pair for " + s.get_symbol() + ", no reference rate");
+      continue;
+    }
+    std::pair<std::string, std::string> names = handle->reversed ? std::make_pair(base_asset, s.get_symbol())
+                                                                 : std::make_pair(s.get_symbol(), base_asset);
+    quotes.insert({rest_pair_names[trading_pair_resolver[names]], Quote{s, !handle->reversed}});
+  }
+
+  // Chunks keep the URL short, they are fetched in parallel over the session pool.
+  std::vector<std::future<Poco::JSON::Object::Ptr>> replies;
+  for (auto it = quotes.begin(); it != quotes.end();) {
+    std::string pairs;
+    for (size_t n = 0; it != quotes.end() && n < ticker_pairs_per_request; ++it, ++n)
+      pairs += (pairs.empty() ? "" : ",") + it->first;
+    replies.push_back(order_workers->submit([this, pairs] {
+      return send_public_get_request("/0/public/Ticker?pair=" + pairs);
+    }));
+  }
+
+  for (auto& reply : replies) {
+    try {
+      Poco::JSON::Object::Ptr resultObject = reply.get()->getObject("result");
+      if (resultObject.isNull()) {
+        poco_warning(logger, "Ticker request returned no result");
+        continue;
+      }
+      for (Poco::JSON::Object::ConstIterator it = resultObject->begin(); it != resultObject->end(); ++it) {
+        auto quote = quotes.find(it->first);
+        if (quote == quotes.end())
+          continue;
+        std::string svalue = it->second.extract<Poco::JSON::Object::Ptr>()->getArray("p")->getElement<std::string>(0);
+        Amount price = Amount::from_string(svalue);
+        if (price.is_zero())
+          continue;
+        const Symbol& s = quote->second.symbol;
+        s.set_reference_rate_estimate(quote->second.usd_quoted ? Amount::from_integer(1).div(price) : price);
+        poco_information(logger, "1 USD = " + s.get_reference_rate_estimate().to_string() + " " + s.get_symbol());
+      }
+    } catch (Poco::Exception& e) {
+      poco_warning(logger, "Ticker request failed: " + e.displayText());
+    }
+  }
+}
+
+std::vector<KrakenPairInfo> KrakenExchange::fetch_asset_pairs() {
+  return parse_asset_pairs(send_public_get_request("/0/public/AssetPairs"));
+}
 
+std::vector<KrakenPairInfo> KrakenExchange::parse_asset_pairs(Poco::JSON::Object::Ptr object) {
   Poco::JSON::Object::Ptr resultObject = object->get("result").extract<Poco::JSON::Object::Ptr>();
 
+  std::vector<KrakenPairInfo> rv;
   for (Poco::JSON::Object::ConstIterator it = resultObject->begin(); it != resultObject->end(); ++it) {
     
     std::string name = it->first;
@@ -309,75 +625,255 @@ void KrakenExchange::fetch_trading_pairs() {
     std::string s1 = asset_pair_object->getValue<std::string>("base");
     std::string s2 = asset_pair_object->getValue<std::string>("quote");
     std::string wsname = asset_pair_object->getValue<std::string>("wsname");
+    unsigned pair_decimals = asset_pair_object->getValue<unsigned>("pair_decimals");
+    unsigned lot_decimals = asset_pair_object->getValue<unsigned>("lot_decimals");
 
     if (ignore_assets.count(s1) > 0 || ignore_assets.count(s2) > 0)
       continue;
 
-    s1 = rewrite_symbol(s1);
-    s2 = rewrite_symbol(s2);
+    rv.push_back({name, wsname, rewrite_symbol(s1), rewrite_symbol(s2), pair_decimals, lot_decimals});
+  }
+  return rv;
+}
+
+void KrakenExchange::add_trading_pairs(const std::vector<KrakenPairInfo>& pairs) {
+  SymbolFactory& symbol_factory = SymbolFactory::get_factory();
 
-    const Symbol& symbol1 = symbol_factory.get_symbol(s1, s1, exchange_string);
-    const Symbol& symbol2 = symbol_factory.get_symbol(s2, s2, exchange_string);
+  for (const KrakenPairInfo& pair : pairs) {
+    const Symbol& symbol1 = symbol_factory.get_symbol(pair.base, pair.base, exchange_string);
+    const Symbol& symbol2 = symbol_factory.get_symbol(pair.quote, pair.quote, exchange_string);
     all_symbols.insert(symbol1);
     all_symbols.insert(symbol2);
 
-    LeveledOrderBook ob(symbol1, symbol2);
-    trading_pair_resolver.insert(std::make_pair(std::make_pair(s1, s2), wsname));
+    if (pair.pair_decimals > decimals || pair.lot_decimals > decimals)
+      poco_warning(logger, "Pair " + pair.wsname + " has more decimals than we keep, levels will be rounded");
+
+    LeveledOrderBook ob(symbol1, symbol2, pair.pair_decimals, pair.lot_decimals, book_depth, book_storage);
+    trading_pair_resolver.insert(std::make_pair(std::make_pair(pair.base, pair.quote), pair.wsname));
+    rest_pair_names.insert({pair.wsname, pair.name});
 
-    auto ob_it = (trading_pairs.insert(std::make_pair(wsname, std::move(ob)))).first;
+    auto ob_it = (trading_pairs.insert(std::make_pair(pair.wsname, std::move(ob)))).first;
     ReverseOrderBook rev_ob(ob_it->second);
-    reverse_order_books.insert(std::make_pair(wsname, std::move(rev_ob)));
+    reverse_order_books.insert(std::make_pair(pair.wsname, std::move(rev_ob)));
   }
+  pair_infos = pairs;
 
+  rebuild_pair_index();
+}
 
-  for (const Symbol& s : all_symbols) {
-    if (s.get_symbol() == base_asset) {
-      s.set_reference_rate_estimate(dec_power);
+bool KrakenExchange::load_warm_cache() {
+  if (warm_cache_path.empty())
+    return false;
+  KrakenWarmState state;
+  try {
+    if (!load_kraken_warm_cache(warm_cache_path, state) || state.pairs.empty()) {
+      poco_warning(logger, "No usable warm-start cache in " + warm_cache_path);
+      return false;
+    }
+  } catch (Poco::Exception& e) {
+    poco_warning(logger, "Cannot read warm-start cache " + warm_cache_path + ": " + e.displayText());
+    return false;
+  }
+  auto age = std::chrono::system_clock::now() - std::chrono::system_clock::time_point(std::chrono::seconds(state.saved_at));
+  if (age > warm_cache_max_age) {
+    poco_notice(logger, "Warm-start cache is too old, loading pairs from the API");
+    return false;
+  }
+
+  add_trading_pairs(state.pairs);
+  size_t restored = 0;
+  for (size_t i = 0; i < state.pairs.size(); i++) {
+    if (state.books[i].empty())
+      continue;
+    LeveledOrderBook& ob = trading_pairs.find(state.pairs[i].wsname)->second;
+    ob.restore(state.books[i]);
+    book_changes.push(ob);
+    restored++;
+  }
+  for (const auto& [symbol, rate] : state.reference_rates)
+    SymbolFactory::get_factory().get_symbol(symbol, symbol, exchange_string).set_reference_rate_estimate(rate);
+
+  poco_notice(logger, "Warm start: " + std::to_string(state.pairs.size()) + " pairs, " + std::to_string(restored)
+                      + " stale books from a cache saved "
+                      + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(age).count()) + "s ago");
+  return true;
+}
+
+void KrakenExchange::validate_trading_pairs(const std::vector<KrakenPairInfo>& live) {
+  std::map<std::string, const KrakenPairInfo*, std::less<>> live_pairs;
+  for (const KrakenPairInfo& pair : live)
+    live_pairs.insert({pair.wsname, &pair});
+
+  // Books and the pair index are shared with the strategy by now, so they are not
+  // rebuilt: mismatching pairs are only disarmed, the next start uses live metadata.
+  size_t mismatches = 0;
+  for (const KrakenPairInfo& cached : pair_infos) {
+    LeveledOrderBook& ob = trading_pairs.find(cached.wsname)->second;
+    auto it = live_pairs.find(cached.wsname);
+    if (it == live_pairs.end() || it->second->base != cached.base || it->second->quote != cached.quote) {
+      poco_warning(logger, "Cached pair " + cached.wsname + " is no longer listed as such, disabling its book");
+      ob.invalidate();
+      book_changes.push(ob);
+      mismatches++;
       continue;
     }
+    const KrakenPairInfo& current = *it->second;
+    if (current.pair_decimals != cached.pair_decimals || current.lot_decimals != cached.lot_decimals) {
+      poco_warning(logger, "Decimals of " + cached.wsname + " changed, skipping its checksums until restart");
+      ob.disable_checksum();
+      mismatches++;
+    }
+    if (current.name != cached.name) {
+      rest_pair_names[cached.wsname] = current.name;
+      mismatches++;
+    }
+    live_pairs.erase(it);
+  }
+  if (!live_pairs.empty())
+    poco_warning(logger, std::to_string(live_pairs.size()) + " new pairs since the cache was saved, they are picked up on restart");
+  if (mismatches == 0 && live_pairs.empty())
+    poco_notice(logger, "Cached pairs match AssetPairs");
+  pair_infos = live;
+}
 
-    uint64_t v1 = try_fetch_reference_rate(s.get_symbol()+"USD");
-    uint64_t v2 = v1 > 0 ? 0 : try_fetch_reference_rate("USD"+s.get_symbol());
-    uint64_t v = v1 == 0 ? v2 : dec_power * dec_power / v1;
-    //std::max(v2, v1 == 0 ? 0 : dec_power * dec_power / v1);
-    s.set_reference_rate_estimate(v);
-    poco_information(logger, "1 USD = " + std::to_string(s.get_reference_rate_estimate()) + " " + s.get_symbol());
+void KrakenExchange::save_warm_cache() {
+  KrakenWarmState state;
+  state.saved_at = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  state.book_depth = book_depth;
+  state.pairs = pair_infos;
+  for (const Symbol& s : all_symbols) {
+    if (!s.get_reference_rate_estimate().is_zero())
+      state.reference_rates.push_back({s.get_symbol(), s.get_reference_rate_estimate()});
   }
+  state.books.resize(state.pairs.size());
+  for (size_t i = 0; i < state.pairs.size(); i++) {
+    auto ob_it = trading_pairs.find(state.pairs[i].wsname);
+    if (ob_it != trading_pairs.end())
+      ob_it->second.get_levels(state.books[i]);
+  }
+  save_kraken_warm_cache(warm_cache_path, state);
+}
 
+void KrakenExchange::save_warm_cache_periodically() {
+  while (true) {
+    try {
+      save_warm_cache();
+      poco_debug(logger, "Saved warm-start cache " + warm_cache_path);
+    } catch (Poco::Exception& e) {
+      poco_warning(logger, "Cannot save warm-start cache " + warm_cache_path + ": " + e.displayText());
+    }
+    std::this_thread::sleep_for(warm_cache_interval);
+  }
 }
 
-bool KrakenExchange::send_trade_sync(const Symbol& symbol1, const Symbol& symbol2, const uint64_t amount) {
-  std::string content = "";
+bool KrakenExchange::order_params(const Symbol& symbol1, const Symbol& symbol2, Amount amount, OrderParams& params) {
   if (has_trading_pair(symbol1, symbol2)) {
-    content = "pair=" + trading_pair_resolver[std::make_pair(symbol1.get_symbol(), symbol2.get_symbol())]
-        + "&type=buy&ordertype=market&volume=" + amount_to_string(amount);
+    params.pair = trading_pair_resolver[std::make_pair(symbol1.get_symbol(), symbol2.get_symbol())];
+    params.type = "buy";
+    params.volume = volume_to_string(amount, trading_pairs.find(params.pair)->second.get_lot_decimals());
   } else if (has_trading_pair(symbol2, symbol1)) {
     auto& ob = this->get_order_book(symbol1, symbol2);
-    uint64_t exchanged_amount = ob.estimate_conversion_from_1(amount);
-    content = "pair=" + trading_pair_resolver[std::make_pair(symbol2.get_symbol(), symbol1.get_symbol())]
-        + "&type=sell&ordertype=market&volume=" + amount_to_string(exchanged_amount);
+    Amount exchanged_amount = Amount::from_raw(ob.estimate_conversion_from_1(amount.raw()));
+    params.pair = trading_pair_resolver[std::make_pair(symbol2.get_symbol(), symbol1.get_symbol())];
+    params.type = "sell";
+    params.volume = volume_to_string(exchanged_amount, trading_pairs.find(params.pair)->second.get_lot_decimals());
   } else {
     // unknown trade pair...
     poco_critical(logger, "Trying to trade unknown trade pair " + symbol1.get_symbol() + "/" + symbol2.get_symbol());
     return false;
   }
+  return true;
+}
 
+// {"error": ["EGeneral:..."], "result": {"descr": {...}, "txid": ["..."]}}
+OrderResult KrakenExchange::send_order(const OrderParams& params) {
+  std::string content = "pair=" + params.pair + "&type=" + params.type + "&ordertype=market&volume=" + params.volume;
+  OrderResult rv;
   try {
-    Poco::JSON::Object::Ptr resultObject = send_authenticated_post_request(http_buy_endpoint, content);
-    // parse the response here and see if the error field is empty and txid is returned.
-    if (resultObject->has("error")) {
-      Poco::JSON::Array::Ptr errors = resultObject->getArray("error");
-      if (errors->size() > 0) {
-        return false;
-      }
-    }
-    if (!resultObject->has("txid")) {
-      return false;
-    }
-    return true;
-
+    Poco::JSON::Object::Ptr object = send_authenticated_post_request(http_buy_endpoint, content);
+    Poco::JSON::Array::Ptr errors = object->getArray("error");
+    for (size_t i = 0; !errors.isNull() && i < errors->size(); i++)
+      rv.errors.push_back(errors->getElement<std::string>(i));
+    Poco::JSON::Object::Ptr result = object->getObject("result");
+    Poco::JSON::Array::Ptr txids;
+    if (!result.isNull())
+      txids = result->getArray("txid");
+    for (size_t i = 0; !txids.isNull() && i < txids->size(); i++)
+      rv.txids.push_back(txids->getElement<std::string>(i));
   } catch (order_failed_exception& e) {
-    poco_error(logger, "failed to enter order for trade " + symbol1.get_symbol() + "/" + symbol2.get_symbol() + " of volume " + std::to_string(amount));
-    return false;
+    rv.errors.push_back("HTTP " + std::to_string(e.get_status_code()) + " " + e.get_reason());
+  } catch (Poco::Exception& e) {
+    rv.errors.push_back(e.displayText());
+  }
+  rv.ok = rv.errors.empty() && !rv.txids.empty();
+  if (!rv.ok)
+    poco_error(logger, "Order " + content + " failed" + (rv.errors.empty() ? std::string() : ": " + rv.errors.front()));
+  return rv;
+}
+
+std::string KrakenExchange::fetch_ws_token() {
+  Poco::JSON::Object::Ptr object = send_authenticated_post_request(ws_token_endpoint, "");
+  Poco::JSON::Object::Ptr result = object->getObject("result");
+  if (result.isNull() || !result->has("token"))
+    throw not_found_exception(std::string("No WebSocket token in ") + ws_token_endpoint);
+  return result->getValue<std::string>("token");
+}
+
+std::future<OrderResult> KrakenExchange::send_trade_async(const Symbol& symbol1, const Symbol& symbol2, Amount amount,
+                                                          OrderCallback on_done) {
+  // The order is priced here, only the round trip happens elsewhere.
+  const uint64_t trigger_ns = trace_trigger_ns;
+  const uint64_t queued_ns = trace_now();
+  OrderParams params;
+  if (!order_params(symbol1, symbol2, amount, params)) {
+    OrderResult rejected;
+    rejected.errors.push_back("Unknown pair " + symbol1.get_symbol() + "/" + symbol2.get_symbol());
+    if (on_done)
+      on_done(rejected);
+    std::promise<OrderResult> promise;
+    promise.set_value(std::move(rejected));
+    return promise.get_future();
   }
+  if (!order_workers) {
+    OrderResult rejected;
+    rejected.errors.push_back("Offline, no orders are sent");
+    if (on_done)
+      on_done(rejected);
+    std::promise<OrderResult> promise;
+    promise.set_value(std::move(rejected));
+    return promise.get_future();
+  }
+  if (ws_trading) {
+    // add_order writes to the socket right away; when the session is down it
+    // sends nothing and leaves on_done alone, and the order goes over REST.
+    const uint64_t sent_ns = trace_now();
+    if (auto sent = ws_trading->add_order(params.pair, params.type, params.volume, std::move(on_done))) {
+      trace_span(TraceSpan::OrderQueue, queued_ns, sent_ns);
+      trace_span(TraceSpan::TickToTrade, trigger_ns, sent_ns);
+      return std::move(*sent);
+    }
+  }
+  return order_workers->submit([this, params = std::move(params), on_done = std::move(on_done), trigger_ns, queued_ns] {
+    const uint64_t sent_ns = trace_now();
+    trace_span(TraceSpan::OrderQueue, queued_ns, sent_ns);
+    trace_span(TraceSpan::TickToTrade, trigger_ns, sent_ns);
+    OrderResult result = send_order(params);
+    trace_span(TraceSpan::OrderRoundTrip, sent_ns, trace_now());
+    if (on_done)
+      on_done(result);
+    return result;
+  });
+}
+
+std::vector<std::future<OrderResult>> KrakenExchange::send_trades_async(std::span<const TradeLeg> legs, OrderCallback on_done) {
+  std::vector<std::future<OrderResult>> rv;
+  rv.reserve(legs.size());
+  for (const TradeLeg& leg : legs)
+    rv.push_back(send_trade_async(leg.from, leg.to, leg.amount, on_done));
+  return rv;
+}
+
+bool KrakenExchange::send_trade_sync(const Symbol& symbol1, const Symbol& symbol2, const uint64_t amount) {
+  return send_trade_async(symbol1, symbol2, Amount::from_raw(amount)).get().ok;
 }
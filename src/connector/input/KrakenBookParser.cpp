@@ -0,0 +1,177 @@
+#include "connector/input/KrakenBookParser.hpp"
+
+namespace {
+
+class Cursor {
+  const char* p;
+  const char* const end;
+public:
+  Cursor(const char* data, size_t size) : p(data), end(data + size) {}
+
+  void skip_ws() {
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+      ++p;
+  }
+
+  bool consume(char c) {
+    skip_ws();
+    if (p < end && *p == c) {
+      ++p;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    skip_ws();
+    return p < end && *p == c;
+  }
+
+  bool at_end() {
+    skip_ws();
+    return p == end;
+  }
+
+  bool string(std::string_view& out) {
+    if (!consume('"'))
+      return false;
+    const char* start = p;
+    while (p < end && *p != '"') {
+      if (*p == '\\')
+        ++p;
+      ++p;
+    }
+    if (p >= end)
+      return false;
+    out = std::string_view(start, p - start);
+    ++p;
+    return true;
+  }
+
+  bool number() {
+    skip_ws();
+    const char* start = p;
+    while (p < end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+      ++p;
+    return p != start;
+  }
+
+  // Skips any JSON value, used for fields we do not care about.
+  bool skip_value() {
+    skip_ws();
+    if (p >= end)
+      return false;
+    if (*p == '"') {
+      std::string_view ignored;
+      return string(ignored);
+    }
+    if (*p != '[' && *p != '{') {
+      const char* start = p;
+      while (p < end && *p != ',' && *p != ']' && *p != '}' && *p != ' ')
+        ++p;
+      return p != start;
+    }
+    int depth = 0;
+    while (p < end) {
+      char c = *p;
+      if (c == '"') {
+        std::string_view ignored;
+        if (!string(ignored))
+          return false;
+        continue;
+      }
+      ++p;
+      if (c == '[' || c == '{') {
+        depth++;
+      } else if (c == ']' || c == '}') {
+        if (--depth == 0)
+          return true;
+      }
+    }
+    return false;
+  }
+};
+
+// [[price, volume, timestamp(, "r")], ...]
+bool parse_levels(Cursor& cursor, BookSide side, KrakenBookFrame& frame) {
+  if (!cursor.consume('['))
+    return false;
+  if (cursor.consume(']'))
+    return true;
+  do {
+    KrakenBookLevel level{side};
+    if (!cursor.consume('[') || !cursor.string(level.price) || !cursor.consume(',') || !cursor.string(level.volume))
+      return false;
+    while (cursor.consume(',')) {
+      if (!cursor.skip_value())
+        return false;
+    }
+    if (!cursor.consume(']'))
+      return false;
+    frame.levels.push_back(level);
+  } while (cursor.consume(','));
+  return cursor.consume(']');
+}
+
+// {"a": [...], "b": [...], "c": "checksum"}
+bool parse_changes(Cursor& cursor, KrakenBookFrame& frame) {
+  if (!cursor.consume('{'))
+    return false;
+  if (cursor.consume('}'))
+    return true;
+  do {
+    std::string_view key;
+    if (!cursor.string(key) || !cursor.consume(':'))
+      return false;
+
+    bool ok;
+    if (key == "a" || key == "as") {
+      frame.snapshot |= key.size() == 2;
+      ok = parse_levels(cursor, BookSide::Ask, frame);
+    } else if (key == "b" || key == "bs") {
+      frame.snapshot |= key.size() == 2;
+      ok = parse_levels(cursor, BookSide::Bid, frame);
+    } else if (key == "c") {
+      ok = cursor.string(frame.checksum);
+    } else {
+      ok = cursor.skip_value();
+    }
+    if (!ok)
+      return false;
+  } while (cursor.consume(','));
+  return cursor.consume('}');
+}
+} //namespace
+
+void KrakenBookFrame::clear() {
+  channel = {};
+  pair = {};
+  checksum = {};
+  snapshot = false;
+  levels.clear();
+}
+
+bool parse_kraken_book_frame(const char* data, size_t size, KrakenBookFrame& frame) {
+  frame.clear();
+  Cursor cursor(data, size);
+
+  if (!cursor.consume('[') || !cursor.number())
+    return false;
+
+  // One or two change objects follow the channel id, then channel name and pair.
+  int objects = 0;
+  while (cursor.consume(',')) {
+    if (!cursor.peek('{'))
+      break;
+    if (!parse_changes(cursor, frame))
+      return false;
+    objects++;
+  }
+
+  if (objects == 0 || !cursor.string(frame.channel) || !cursor.consume(',') || !cursor.string(frame.pair))
+    return false;
+  if (!cursor.consume(']') || !cursor.at_end())
+    return false;
+
+  return frame.channel.substr(0, 4) == "book";
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "connector/input/KrakenFeedShard.hpp"
+
+std::vector<ShardMove> plan_shard_moves(std::span<const uint64_t> rates, std::span<const uint32_t> writers,
+                                        uint32_t shard_count, size_t max_moves, double tolerance) {
+  std::vector<ShardMove> rv;
+  if (shard_count < 2)
+    return rv;
+  std::vector<uint64_t> loads(shard_count, 0);
+  uint64_t total = 0;
+  for (size_t i = 0; i < rates.size(); i++) {
+    if (writers[i] < shard_count) {
+      loads[writers[i]] += rates[i];
+      total += rates[i];
+    }
+  }
+  const double limit = double(total) / shard_count * (1 + tolerance);
+  std::vector<bool> moved(rates.size(), false);
+
+  while (rv.size() < max_moves) {
+    const uint32_t busiest = std::max_element(loads.begin(), loads.end()) - loads.begin();
+    const uint32_t idlest = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    if (total == 0 || loads[busiest] <= limit)
+      break;
+    // Moving rate r turns the gap into |gap - 2r|, anything below gap narrows it.
+    const uint64_t gap = loads[busiest] - loads[idlest];
+    size_t best = rates.size();
+    uint64_t best_gap = gap;
+    for (size_t i = 0; i < rates.size(); i++) {
+      if (writers[i] != busiest || moved[i] || rates[i] == 0 || rates[i] >= gap)
+        continue;
+      const uint64_t new_gap = gap > 2 * rates[i] ? gap - 2 * rates[i] : 2 * rates[i] - gap;
+      if (new_gap < best_gap) {
+        best = i;
+        best_gap = new_gap;
+      }
+    }
+    if (best == rates.size())
+      break;
+    moved[best] = true;
+    loads[busiest] -= rates[best];
+    loads[idlest] += rates[best];
+    rv.push_back({best, busiest, idlest});
+  }
+  return rv;
+}
+
+bool pin_thread_to_cpu(int cpu) {
+#if defined(__linux__)
+  if (cpu < 0 || cpu >= CPU_SETSIZE)
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,163 @@
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/JSON/Parser.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "connector/input/Kraken.hpp"
+#include "Exceptions.hpp"
+
+namespace {
+static std::string exchange_string("kraken");
+
+bool is_recording(const std::string& path) {
+  char magic[4] = {};
+  std::ifstream in(path, std::ios::binary);
+  in.read(magic, sizeof(magic));
+  return in && std::memcmp(magic, "BKMR", sizeof(magic)) == 0;
+}
+
+// Splits an optional "<time> " prefix off a text capture line. Times with a
+// fraction or below 1e12 are unix seconds, others nanoseconds. Returns 0 when
+// the line has no time.
+uint64_t split_receive_time(std::string_view& line) {
+  if (line.empty() || line[0] < '0' || line[0] > '9')
+    return 0;
+  uint64_t whole = 0;
+  const char* pos = line.data();
+  const char* const end = line.data() + line.size();
+  pos = std::from_chars(pos, end, whole).ptr;
+  uint64_t ns = whole;
+  if (pos != end && *pos == '.') {
+    uint64_t fraction = 0, scale = 1000000000;
+    for (++pos; pos != end && *pos >= '0' && *pos <= '9'; ++pos) {
+      if (scale > 1) {
+        scale /= 10;
+        fraction += (*pos - '0') * scale;
+      }
+    }
+    ns = whole * 1000000000 + fraction;
+  } else if (whole < 1000000000000) {
+    ns = whole * 1000000000;
+  }
+  while (pos != end && (*pos == ' ' || *pos == '\t'))
+    ++pos;
+  line = std::string_view(pos, end - pos);
+  return ns;
+}
+} //namespace
+
+void KrakenExchange::load_pairs_offline() {
+  std::string pairs_path = config->getString("Kraken.ReplayPairs", "");
+  if (!pairs_path.empty()) {
+    std::ifstream in(pairs_path);
+    if (!in)
+      throw not_found_exception("Cannot read " + pairs_path);
+    Poco::JSON::Parser parser;
+    add_trading_pairs(parse_asset_pairs(parser.parse(in).extract<Poco::JSON::Object::Ptr>()));
+  } else {
+    KrakenWarmState state;
+    if (warm_cache_path.empty() || !load_kraken_warm_cache(warm_cache_path, state))
+      throw not_found_exception("Offline start needs Kraken.ReplayPairs or a warm-start cache");
+    // Only the metadata, books come from the capture.
+    add_trading_pairs(state.pairs);
+    for (const auto& [symbol, rate] : state.reference_rates)
+      SymbolFactory::get_factory().get_symbol(symbol, symbol, exchange_string).set_reference_rate_estimate(rate);
+  }
+  initialized = true;
+  poco_notice(logger, "Loaded " + std::to_string(trading_pairs.size()) + " pairs offline");
+}
+
+void KrakenExchange::apply_recorded_frame(KrakenFeedShard& shard, const RecordedFrame& frame) {
+  auto ob_it = trading_pairs.find(frame.pair);
+  if (ob_it == trading_pairs.end()) {
+    poco_warning(logger, "Book update for unknown pair " + std::string(frame.pair));
+    return;
+  }
+  LeveledOrderBook& ob = ob_it->second;
+  if (!frame.snapshot && !ob.is_valid())
+    return;
+  ob.apply_updates(frame.levels, frame.snapshot);
+  trace_book_update(shard, ob);
+  book_changes.push(ob);
+}
+
+KrakenExchange::ReplayStats KrakenExchange::replay(const std::string& path, bool real_time,
+                                                   const std::function<void()>& on_frame) {
+  std::vector<std::string> files = Poco::File(path).exists() ? std::vector<std::string>{path} : recording_parts(path);
+  if (files.empty())
+    throw not_found_exception("No capture at " + path);
+
+  ReplayStats stats;
+  KrakenFeedShard& shard = *shards.front();
+  KrakenBookFrame frame;
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t first_ns = 0;
+  bool unpaced_warned = false;
+
+  auto run_frame = [&](uint64_t receive_ns, auto&& apply) {
+    if (real_time) {
+      if (receive_ns == 0) {
+        if (!unpaced_warned)
+          poco_warning(logger, "Capture has frames without a receive time, those are replayed at once");
+        unpaced_warned = true;
+      } else {
+        if (first_ns == 0)
+          first_ns = receive_ns;
+        if (receive_ns > first_ns)
+          std::this_thread::sleep_until(start + std::chrono::nanoseconds(receive_ns - first_ns));
+      }
+    }
+    shard.frame_receive_ns = receive_ns;
+    // Trace spans start when the frame is replayed, columnar frames come parsed.
+    shard.frame_trace_ns = shard.frame_parsed_ns = trace_now();
+    stats.frames++;
+    apply();
+    // There is no feed to resubscribe to, the book stays invalid until the
+    // capture has its next snapshot.
+    stats.resyncs += shard.resync_pairs.size();
+    shard.resync_pairs.clear();
+    if (on_frame)
+      on_frame();
+  };
+
+  for (const std::string& file : files) {
+    if (is_recording(file)) {
+      MarketRecordingReader reader(file);
+      RecordedFrame recorded;
+      while (reader.next(recorded)) {
+        run_frame(recorded.receive_ns, [&] {
+          if (reader.get_format() == RecordingFormat::Columnar) {
+            apply_recorded_frame(shard, recorded);
+            stats.book_frames++;
+            stats.levels += recorded.levels.size();
+          } else if (handle_frame(shard, recorded.raw.data(), recorded.raw.size(), frame)) {
+            stats.book_frames++;
+            stats.levels += frame.levels.size();
+          }
+        });
+      }
+    } else {
+      std::ifstream in(file);
+      std::string line;
+      while (std::getline(in, line)) {
+        std::string_view text(line);
+        uint64_t receive_ns = split_receive_time(text);
+        if (text.empty())
+          continue;
+        run_frame(receive_ns, [&] {
+          if (handle_frame(shard, text.data(), text.size(), frame)) {
+            stats.book_frames++;
+            stats.levels += frame.levels.size();
+          }
+        });
+      }
+    }
+  }
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return stats;
+}
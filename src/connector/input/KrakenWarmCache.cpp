@@ -0,0 +1,181 @@
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/SharedMemory.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "connector/input/KrakenWarmCache.hpp"
+#include "Crc32.hpp"
+
+namespace {
+// File layout, all integers in host byte order:
+//   header:  magic "BKWC", u32 version, u64 saved_at, u32 book_depth,
+//            u32 pair count, u32 rate count, u32 crc32 of everything after the header
+//   pairs:   str name, str wsname, str base, str quote, u8 pair_decimals, u8 lot_decimals
+//   rates:   str symbol, i128 rate
+//   books:   u32 level count, then per level u8 side, i128 price, i128 volume
+// where str is a u16 length followed by the bytes. Books follow the pair order.
+static const char cache_magic[4] = {'B', 'K', 'W', 'C'};
+static const uint32_t cache_version = 1;
+
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t saved_at;
+  uint32_t book_depth;
+  uint32_t pair_count;
+  uint32_t rate_count;
+  uint32_t crc;
+};
+
+class CacheWriter {
+  std::string& out;
+public:
+  explicit CacheWriter(std::string& out) : out(out) {}
+
+  template <class T>
+  void put(T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+  void put_string(const std::string& s) {
+    put(static_cast<uint16_t>(s.size()));
+    out.append(s);
+  }
+  void put_amount(Amount amount) { put(amount.raw()); }
+};
+
+// Bounds checked cursor over the mapped file, a short read fails instead of
+// running past the mapping.
+class CacheReader {
+  const char* pos;
+  const char* const end;
+public:
+  CacheReader(const char* begin, const char* end) : pos(begin), end(end) {}
+
+  template <class T>
+  bool get(T& value) {
+    if (static_cast<size_t>(end - pos) < sizeof(value))
+      return false;
+    std::memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+  }
+  bool get_string(std::string& s) {
+    uint16_t size;
+    if (!get(size) || static_cast<size_t>(end - pos) < size)
+      return false;
+    s.assign(pos, size);
+    pos += size;
+    return true;
+  }
+  bool get_amount(Amount& amount) {
+    __int128 raw;
+    if (!get(raw))
+      return false;
+    amount = Amount::from_raw(raw);
+    return true;
+  }
+  bool at_end() const { return pos == end; }
+};
+
+bool decode(CacheReader& reader, const CacheHeader& header, KrakenWarmState& state) {
+  state.pairs.resize(header.pair_count);
+  for (KrakenPairInfo& pair : state.pairs) {
+    uint8_t pair_decimals, lot_decimals;
+    if (!reader.get_string(pair.name) || !reader.get_string(pair.wsname) || !reader.get_string(pair.base)
+        || !reader.get_string(pair.quote) || !reader.get(pair_decimals) || !reader.get(lot_decimals))
+      return false;
+    pair.pair_decimals = pair_decimals;
+    pair.lot_decimals = lot_decimals;
+  }
+
+  state.reference_rates.resize(header.rate_count);
+  for (auto& [symbol, rate] : state.reference_rates) {
+    if (!reader.get_string(symbol) || !reader.get_amount(rate))
+      return false;
+  }
+
+  state.books.resize(header.pair_count);
+  for (std::vector<LevelUpdate>& levels : state.books) {
+    uint32_t count;
+    if (!reader.get(count) || count > 2 * header.book_depth)
+      return false;
+    levels.resize(count);
+    for (LevelUpdate& level : levels) {
+      uint8_t side;
+      if (!reader.get(side) || !reader.get_amount(level.price) || !reader.get_amount(level.volume))
+        return false;
+      level.side = side == 0 ? BookSide::Ask : BookSide::Bid;
+    }
+  }
+  return reader.at_end();
+}
+} //namespace
+
+void save_kraken_warm_cache(const std::string& path, const KrakenWarmState& state) {
+  std::string payload;
+  CacheWriter writer(payload);
+  for (const KrakenPairInfo& pair : state.pairs) {
+    writer.put_string(pair.name);
+    writer.put_string(pair.wsname);
+    writer.put_string(pair.base);
+    writer.put_string(pair.quote);
+    writer.put(static_cast<uint8_t>(pair.pair_decimals));
+    writer.put(static_cast<uint8_t>(pair.lot_decimals));
+  }
+  for (const auto& [symbol, rate] : state.reference_rates) {
+    writer.put_string(symbol);
+    writer.put_amount(rate);
+  }
+  for (size_t i = 0; i < state.pairs.size(); i++) {
+    static const std::vector<LevelUpdate> no_levels;
+    const std::vector<LevelUpdate>& levels = i < state.books.size() ? state.books[i] : no_levels;
+    writer.put(static_cast<uint32_t>(levels.size()));
+    for (const LevelUpdate& level : levels) {
+      writer.put(static_cast<uint8_t>(level.side == BookSide::Ask ? 0 : 1));
+      writer.put_amount(level.price);
+      writer.put_amount(level.volume);
+    }
+  }
+
+  CacheHeader header{};
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = cache_version;
+  header.saved_at = state.saved_at;
+  header.book_depth = state.book_depth;
+  header.pair_count = state.pairs.size();
+  header.rate_count = state.reference_rates.size();
+  header.crc = crc32(payload.data(), payload.size());
+
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), payload.size());
+    out.close();
+    if (!out)
+      throw Poco::IOException("Cannot write " + tmp_path);
+  }
+  Poco::File(tmp_path).renameTo(path);
+}
+
+bool load_kraken_warm_cache(const std::string& path, KrakenWarmState& state) {
+  Poco::File file(path);
+  if (!file.exists() || file.getSize() < sizeof(CacheHeader))
+    return false;
+
+  Poco::SharedMemory mapping(file, Poco::SharedMemory::AM_READ);
+  CacheHeader header;
+  std::memcpy(&header, mapping.begin(), sizeof(header));
+  if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version)
+    return false;
+
+  const char* payload = mapping.begin() + sizeof(header);
+  const size_t payload_size = mapping.end() - payload;
+  if (crc32(payload, payload_size) != header.crc)
+    return false;
+
+  state.saved_at = header.saved_at;
+  state.book_depth = header.book_depth;
+  CacheReader reader(payload, mapping.end());
+  return decode(reader, header, state);
+}
@@ -0,0 +1,153 @@
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "connector/input/MarketRecorder.hpp"
+
+namespace {
+// Columnar frames per block, more compress better but are lost together on a crash.
+static const uint32_t block_frames = 4096;
+static const size_t write_batch_bytes = 1 << 20;
+// Whatever is buffered is written out at least this often.
+static const std::chrono::seconds flush_interval(1);
+
+// Ring records: u64 receive_ns, then the frame text for raw recorders, or u8
+// snapshot, u16 pair size, the pair and the LevelUpdate array for columnar ones.
+template <class T>
+std::span<const char> bytes_of(const T& value) {
+  return {reinterpret_cast<const char*>(&value), sizeof(value)};
+}
+
+uint64_t part_number(const std::string& part) {
+  return std::stoull(part.substr(part.rfind('.') + 1));
+}
+} //namespace
+
+MarketRecorder::MarketRecorder(const Options& options) :
+    options(options), ring(options.ring_bytes), logger(Poco::Logger::root().get("Recorder")) {
+  // Continue numbering after an earlier recording instead of overwriting it.
+  std::vector<std::string> existing = recording_parts(options.path);
+  if (!existing.empty())
+    next_part = part_number(existing.back()) + 1;
+  open_next_part();
+  if (!out)
+    throw Poco::FileException("Cannot open recording " + options.path);
+  writer = std::thread(&MarketRecorder::write_loop, this);
+}
+
+MarketRecorder::~MarketRecorder() {
+  running.store(false, std::memory_order_release);
+  writer.join();
+}
+
+uint64_t MarketRecorder::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void MarketRecorder::record_frame(uint64_t receive_ns, const char* data, size_t size) {
+  if (options.format != RecordingFormat::Raw)
+    return;
+  ring.push({bytes_of(receive_ns), std::span<const char>(data, size)});
+}
+
+void MarketRecorder::record_levels(uint64_t receive_ns, std::string_view pair, bool snapshot,
+                                   std::span<const LevelUpdate> levels) {
+  if (options.format != RecordingFormat::Columnar)
+    return;
+  const uint8_t flag = snapshot;
+  const uint16_t pair_size = pair.size();
+  ring.push({bytes_of(receive_ns), bytes_of(flag), bytes_of(pair_size), std::span<const char>(pair.data(), pair.size()),
+             std::span<const char>(reinterpret_cast<const char*>(levels.data()), levels.size_bytes())});
+}
+
+void MarketRecorder::write_loop() {
+  auto last_flush = std::chrono::steady_clock::now();
+  while (true) {
+    const bool stopping = !running.load(std::memory_order_acquire);
+    size_t records = ring.consume(scratch, [this](std::span<const char> record) { write_record(record); });
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_flush >= flush_interval) {
+      flush_pending();
+      last_flush = now;
+    }
+    if (records == 0) {
+      if (stopping)
+        break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  flush_pending();
+  out.close();
+  if (ring.dropped() > 0)
+    poco_warning(logger, "Recorder dropped " + std::to_string(ring.dropped()) + " frames");
+}
+
+void MarketRecorder::write_record(std::span<const char> record) {
+  uint64_t receive_ns;
+  std::memcpy(&receive_ns, record.data(), sizeof(receive_ns));
+  record = record.subspan(sizeof(receive_ns));
+
+  if (options.format == RecordingFormat::Raw) {
+    const uint32_t size = record.size();
+    pending.append(reinterpret_cast<const char*>(&receive_ns), sizeof(receive_ns));
+    pending.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    pending.append(record.data(), record.size());
+    if (pending.size() >= write_batch_bytes)
+      flush_pending();
+  } else {
+    uint8_t snapshot;
+    uint16_t pair_size;
+    std::memcpy(&snapshot, record.data(), sizeof(snapshot));
+    std::memcpy(&pair_size, record.data() + sizeof(snapshot), sizeof(pair_size));
+    const char* pair = record.data() + sizeof(snapshot) + sizeof(pair_size);
+    const char* level_data = pair + pair_size;
+    levels.resize((record.data() + record.size() - level_data) / sizeof(LevelUpdate));
+    std::memcpy(levels.data(), level_data, levels.size() * sizeof(LevelUpdate));
+    encoder.add(receive_ns, std::string_view(pair, pair_size), snapshot != 0, levels);
+    if (encoder.frames() >= block_frames)
+      flush_pending();
+  }
+  records_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MarketRecorder::flush_pending() {
+  encoder.flush(pending);
+  if (pending.empty())
+    return;
+  out.write(pending.data(), pending.size());
+  out.flush();
+  file_bytes += pending.size();
+  pending.clear();
+  if (!out && !failed) {
+    poco_error(logger, "Cannot write recording " + options.path + ", frames are lost from now on");
+    failed = true;
+  }
+  if (file_bytes >= options.rotate_bytes)
+    open_next_part();
+}
+
+void MarketRecorder::open_next_part() {
+  if (out.is_open())
+    out.close();
+  const std::string part = options.path + "." + std::to_string(next_part);
+  out.open(part, std::ios::binary | std::ios::trunc);
+  parts.push_back(next_part++);
+  while (options.max_files > 0 && parts.size() > options.max_files) {
+    try {
+      Poco::File(options.path + "." + std::to_string(parts.front())).remove();
+    } catch (Poco::Exception& e) {
+      poco_warning(logger, "Cannot remove old recording part: " + e.displayText());
+    }
+    parts.erase(parts.begin());
+  }
+
+  // Each part decodes on its own.
+  encoder.reset();
+  std::string header;
+  append_recording_header(header, options.format);
+  out.write(header.data(), header.size());
+  file_bytes = header.size();
+}
@@ -0,0 +1,275 @@
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "connector/input/MarketRecording.hpp"
+
+namespace {
+static const char file_magic[4] = {'B', 'K', 'M', 'R'};
+static const char block_magic[4] = {'B', 'K', 'C', 'B'};
+static const uint32_t recording_version = 1;
+
+template <class T>
+void put(std::string& out, T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+void put_varint(std::string& out, unsigned __int128 value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void put_zigzag(std::string& out, __int128 value) {
+  put_varint(out, (static_cast<unsigned __int128>(value) << 1) ^ static_cast<unsigned __int128>(value >> 127));
+}
+
+void put_column(std::string& out, const std::string& column) {
+  put(out, static_cast<uint32_t>(column.size()));
+  out.append(column);
+}
+
+template <class Column>
+bool get_varint(Column& column, unsigned __int128& value) {
+  value = 0;
+  for (unsigned shift = 0; column.pos != column.end && shift < 128; shift += 7) {
+    uint8_t byte = *column.pos++;
+    value |= static_cast<unsigned __int128>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+template <class Column>
+bool get_zigzag(Column& column, __int128& value) {
+  unsigned __int128 raw;
+  if (!get_varint(column, raw))
+    return false;
+  value = static_cast<__int128>(raw >> 1) ^ -static_cast<__int128>(raw & 1);
+  return true;
+}
+} //namespace
+
+void append_recording_header(std::string& out, RecordingFormat format) {
+  out.append(file_magic, sizeof(file_magic));
+  put(out, recording_version);
+  put(out, static_cast<uint32_t>(format));
+}
+
+std::vector<std::string> recording_parts(const std::string& path) {
+  Poco::Path base(path);
+  Poco::Path directory(base.parent());
+  const std::string prefix = base.getFileName() + ".";
+
+  std::vector<std::pair<uint64_t, std::string>> numbered;
+  std::vector<std::string> files;
+  Poco::File(directory).list(files);
+  for (const std::string& name : files) {
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+      continue;
+    uint64_t n;
+    const char* end = name.data() + name.size();
+    auto [ptr, ec] = std::from_chars(name.data() + prefix.size(), end, n);
+    if (ec == std::errc() && ptr == end)
+      numbered.push_back({n, Poco::Path(directory, name).toString()});
+  }
+  std::sort(numbered.begin(), numbered.end());
+  std::vector<std::string> rv;
+  for (auto& [n, part] : numbered)
+    rv.push_back(std::move(part));
+  return rv;
+}
+
+void ColumnarEncoder::add(uint64_t receive_ns, std::string_view pair, bool snapshot, std::span<const LevelUpdate> levels) {
+  auto id_it = pair_ids.find(pair);
+  if (id_it == pair_ids.end()) {
+    id_it = pair_ids.insert({std::string(pair), static_cast<uint32_t>(pair_ids.size())}).first;
+    last_prices.push_back({0, 0});
+    put_varint(names, pair.size());
+    names.append(pair);
+  }
+  const uint32_t id = id_it->second;
+
+  if (frame_count == 0)
+    put_varint(times, receive_ns);
+  else
+    put_zigzag(times, static_cast<__int128>(receive_ns) - static_cast<__int128>(last_ns));
+  last_ns = receive_ns;
+  put_varint(pairs, id);
+  flags.push_back(snapshot ? 1 : 0);
+  put_varint(counts, levels.size());
+
+  auto& [last_ask, last_bid] = last_prices[id];
+  for (const LevelUpdate& level : levels) {
+    const bool bid = level.side == BookSide::Bid;
+    side_bits |= static_cast<uint8_t>(bid) << side_bit_count;
+    if (++side_bit_count == 8) {
+      sides.push_back(static_cast<char>(side_bits));
+      side_bits = 0;
+      side_bit_count = 0;
+    }
+    __int128& last = bid ? last_bid : last_ask;
+    put_zigzag(prices, level.price.raw() - last);
+    last = level.price.raw();
+    put_zigzag(volumes, level.volume.raw());
+  }
+  frame_count++;
+  level_count += levels.size();
+}
+
+void ColumnarEncoder::flush(std::string& out) {
+  if (frame_count == 0)
+    return;
+  if (side_bit_count > 0)
+    sides.push_back(static_cast<char>(side_bits));
+
+  uint32_t payload = 0;
+  for (const std::string* column : {&names, &times, &pairs, &flags, &counts, &sides, &prices, &volumes})
+    payload += sizeof(uint32_t) + column->size();
+  out.append(block_magic, sizeof(block_magic));
+  put(out, frame_count);
+  put(out, level_count);
+  put(out, payload);
+  for (std::string* column : {&names, &times, &pairs, &flags, &counts, &sides, &prices, &volumes}) {
+    put_column(out, *column);
+    column->clear();
+  }
+  side_bits = 0;
+  side_bit_count = 0;
+  frame_count = 0;
+  level_count = 0;
+}
+
+void ColumnarEncoder::reset() {
+  pair_ids.clear();
+  last_prices.clear();
+}
+
+MarketRecordingReader::MarketRecordingReader(const std::string& path) : in(path, std::ios::binary) {
+  char magic[4];
+  uint32_t version = 0, stored_format = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&stored_format), sizeof(stored_format));
+  if (!in || std::memcmp(magic, file_magic, sizeof(magic)) != 0 || version != recording_version
+      || stored_format > static_cast<uint32_t>(RecordingFormat::Columnar))
+    throw Poco::FileException("Not a market recording: " + path);
+  format = static_cast<RecordingFormat>(stored_format);
+}
+
+bool MarketRecordingReader::next(RecordedFrame& frame) {
+  if (format == RecordingFormat::Columnar)
+    return next_columnar(frame);
+
+  uint32_t size;
+  in.read(reinterpret_cast<char*>(&frame.receive_ns), sizeof(frame.receive_ns));
+  in.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (!in)
+    return false;
+  buffer.resize(size);
+  in.read(buffer.data(), size);
+  if (!in)
+    return false;
+  frame.raw = buffer;
+  frame.pair = {};
+  frame.snapshot = false;
+  frame.levels.clear();
+  return true;
+}
+
+bool MarketRecordingReader::next_block() {
+  char magic[4];
+  uint32_t frame_count, level_count, payload;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&frame_count), sizeof(frame_count));
+  in.read(reinterpret_cast<char*>(&level_count), sizeof(level_count));
+  in.read(reinterpret_cast<char*>(&payload), sizeof(payload));
+  if (!in || std::memcmp(magic, block_magic, sizeof(magic)) != 0)
+    return false;
+  buffer.resize(payload);
+  in.read(buffer.data(), payload);
+  if (!in)
+    return false;
+
+  const char* pos = buffer.data();
+  const char* const end = pos + buffer.size();
+  for (Column* column : {&names, &times, &pairs, &flags, &counts, &sides, &prices, &volumes}) {
+    uint32_t size;
+    if (end - pos < static_cast<ptrdiff_t>(sizeof(size)))
+      return false;
+    std::memcpy(&size, pos, sizeof(size));
+    pos += sizeof(size);
+    if (static_cast<size_t>(end - pos) < size)
+      return false;
+    column->pos = pos;
+    column->end = pos + size;
+    pos += size;
+  }
+
+  while (names.pos != names.end) {
+    unsigned __int128 size;
+    if (!get_varint(names, size) || static_cast<size_t>(names.end - names.pos) < size)
+      return false;
+    pair_names.emplace_back(names.pos, static_cast<size_t>(size));
+    last_prices.push_back({0, 0});
+    names.pos += static_cast<size_t>(size);
+  }
+  frames_left = frame_count;
+  block_start = true;
+  side_bit = 8;
+  return true;
+}
+
+bool MarketRecordingReader::next_columnar(RecordedFrame& frame) {
+  while (frames_left == 0) {
+    if (!next_block())
+      return false;
+  }
+  __int128 delta;
+  unsigned __int128 id, count;
+  // The first time of a block is absolute, the others are deltas.
+  if (block_start) {
+    unsigned __int128 absolute;
+    if (!get_varint(times, absolute))
+      return false;
+    last_ns = static_cast<uint64_t>(absolute);
+    block_start = false;
+  } else {
+    if (!get_zigzag(times, delta))
+      return false;
+    last_ns += static_cast<int64_t>(delta);
+  }
+  if (!get_varint(pairs, id) || id >= pair_names.size() || flags.pos == flags.end || !get_varint(counts, count))
+    return false;
+  frame.receive_ns = last_ns;
+  frame.raw = {};
+  frame.pair = pair_names[static_cast<size_t>(id)];
+  frame.snapshot = *flags.pos++ != 0;
+
+  auto& [last_ask, last_bid] = last_prices[static_cast<size_t>(id)];
+  frame.levels.resize(static_cast<size_t>(count));
+  for (LevelUpdate& level : frame.levels) {
+    if (side_bit == 8) {
+      if (sides.pos == sides.end)
+        return false;
+      side_bits = *sides.pos++;
+      side_bit = 0;
+    }
+    const bool bid = (side_bits >> side_bit++) & 1;
+    __int128 price_delta, volume;
+    if (!get_zigzag(prices, price_delta) || !get_zigzag(volumes, volume))
+      return false;
+    __int128& last = bid ? last_bid : last_ask;
+    last += price_delta;
+    level.side = bid ? BookSide::Bid : BookSide::Ask;
+    level.price = Amount::from_raw(last);
+    level.volume = Amount::from_raw(volume);
+  }
+  frames_left--;
+  return true;
+}
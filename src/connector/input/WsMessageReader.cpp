@@ -0,0 +1,28 @@
+#include <Poco/Net/WebSocket.h>
+
+#include "connector/input/WsMessageReader.hpp"
+
+bool WsMessageReader::receive(Poco::Net::WebSocket& ws) {
+  // Keeps the capacity.
+  buffer.resize(0, false);
+  while (true) {
+    const size_t before = buffer.size();
+    int flags = 0;
+    // Appends the frame's payload to the buffer.
+    const int n = ws.receiveFrame(buffer, flags);
+    const int opcode = flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
+    if ((n == 0 && flags == 0) || opcode == Poco::Net::WebSocket::FRAME_OP_CLOSE) {
+      buffer.resize(0, false);
+      return false;
+    }
+    if (opcode >= Poco::Net::WebSocket::FRAME_OP_CLOSE) {
+      // Ping or pong, may arrive between the fragments of a message.
+      buffer.resize(before);
+      continue;
+    }
+    if (opcode != Poco::Net::WebSocket::FRAME_OP_CONT)
+      message_opcode = opcode;
+    if (flags & Poco::Net::WebSocket::FRAME_FLAG_FIN)
+      return true;
+  }
+}
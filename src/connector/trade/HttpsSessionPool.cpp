@@ -0,0 +1,140 @@
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/StreamCopier.h>
+#include "connector/trade/HttpsSessionPool.hpp"
+
+HttpsSessionPool::HttpsSessionPool(Options options) :
+    options(std::move(options)), logger(Poco::Logger::root().get("HttpsSessionPool")), slots(this->options.size) {
+  for (Slot& slot : slots) {
+    if (this->options.context.isNull())
+      slot.session = std::make_unique<Poco::Net::HTTPSClientSession>(this->options.host, this->options.port);
+    else
+      slot.session = std::make_unique<Poco::Net::HTTPSClientSession>(this->options.host, this->options.port, this->options.context);
+    slot.session->setKeepAlive(true);
+    // Our pings keep the connection in use, Poco must not drop it on its own.
+    slot.session->setKeepAliveTimeout(Poco::Timespan(this->options.ping_interval.count() * 4, 0));
+    slot.session->setTimeout(Poco::Timespan(this->options.timeout.count(), 0));
+  }
+  // Connecting happens on the maintenance thread, construction does not block.
+  maintenance = std::thread(&HttpsSessionPool::maintain, this);
+}
+
+HttpsSessionPool::~HttpsSessionPool() {
+  {
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    stopping = true;
+  }
+  maintenance_wakeup.notify_all();
+  maintenance.join();
+}
+
+HttpsSessionPool::Slot& HttpsSessionPool::lease_slot() {
+  std::unique_lock<std::mutex> lock(slots_mutex);
+  Slot* picked = nullptr;
+  slot_released.wait(lock, [&] {
+    // A connected session is preferred, a broken one connects on first use.
+    for (Slot& slot : slots) {
+      if (!slot.leased && (picked == nullptr || (slot.healthy && !picked->healthy)))
+        picked = &slot;
+    }
+    return picked != nullptr;
+  });
+  picked->leased = true;
+  return *picked;
+}
+
+void HttpsSessionPool::release_slot(Slot& slot, bool healthy) {
+  if (!healthy)
+    slot.session->reset();
+  {
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    slot.leased = false;
+    slot.healthy = healthy;
+    // A session broken by a request is reconnected right away.
+    slot.last_used = healthy ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+  }
+  slot_released.notify_one();
+  if (!healthy)
+    maintenance_wakeup.notify_one();
+}
+
+Poco::Net::HTTPResponse::HTTPStatus HttpsSessionPool::send(Poco::Net::HTTPRequest& request, const std::string& content,
+                                                           std::string& response_content) {
+  Slot& slot = lease_slot();
+  try {
+    request.setKeepAlive(true);
+    if (!content.empty())
+      request.setContentLength(content.size());
+    slot.session->sendRequest(request) << content;
+    Poco::Net::HTTPResponse response;
+    std::istream& response_stream = slot.session->receiveResponse(response);
+    response_content.clear();
+    Poco::StreamCopier::copyToString(response_stream, response_content);
+    release_slot(slot, response.getKeepAlive());
+    return response.getStatus();
+  } catch (...) {
+    release_slot(slot, false);
+    throw;
+  }
+}
+
+size_t HttpsSessionPool::healthy_sessions() {
+  std::lock_guard<std::mutex> lock(slots_mutex);
+  size_t healthy = 0;
+  for (const Slot& slot : slots)
+    healthy += !slot.leased && slot.healthy;
+  return healthy;
+}
+
+bool HttpsSessionPool::ping(Slot& slot) {
+  try {
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, options.ping_path, Poco::Net::HTTPMessage::HTTP_1_1);
+    request.setKeepAlive(true);
+    slot.session->sendRequest(request);
+    Poco::Net::HTTPResponse response;
+    std::string ignored;
+    Poco::StreamCopier::copyToString(slot.session->receiveResponse(response), ignored);
+    return response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK && response.getKeepAlive();
+  } catch (Poco::Exception& e) {
+    poco_warning(logger, "Session to " + options.host + " failed its health check: " + e.displayText());
+  } catch (std::exception& e) {
+    poco_warning(logger, "Session to " + options.host + " failed its health check: " + e.what());
+  }
+  return false;
+}
+
+void HttpsSessionPool::maintain() {
+  // Broken sessions are retried this often, so requests find them connected again soon.
+  const auto retry_interval = std::chrono::seconds(1);
+  std::unique_lock<std::mutex> lock(slots_mutex);
+  while (!stopping) {
+    auto now = std::chrono::steady_clock::now();
+    auto next_check = now + options.ping_interval;
+    for (Slot& slot : slots) {
+      if (slot.leased)
+        continue;
+      auto due = slot.last_used + (slot.healthy ? options.ping_interval : retry_interval);
+      if (due > now) {
+        next_check = std::min(next_check, due);
+        continue;
+      }
+      // Broken sessions are reconnected, idle ones pinged, both outside the lock.
+      slot.leased = true;
+      lock.unlock();
+      bool healthy = ping(slot);
+      if (!healthy)
+        slot.session->reset();
+      lock.lock();
+      slot.leased = false;
+      slot.healthy = healthy;
+      slot.last_used = std::chrono::steady_clock::now();
+      slot_released.notify_one();
+      next_check = std::min(next_check, slot.last_used + (healthy ? options.ping_interval : retry_interval));
+      if (stopping)
+        return;
+    }
+    maintenance_wakeup.wait_until(lock, next_check);
+  }
+}
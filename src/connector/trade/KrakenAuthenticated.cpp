@@ -1,13 +1,13 @@
-#include <Poco/Net/HTTPSClientSession.h>
 #include <Poco/Net/HTTPRequest.h>
 #include <Poco/Net/HTTPResponse.h>
-#include <Poco/StreamCopier.h>
 #include <Poco/HMACEngine.h>
 #include <Poco/Base64Encoder.h>
 #include <Poco/SHA2Engine.h>
 #include <iostream>
 #include <sstream>
 #include "Utils.hpp"
+#include "connector/trade/HttpsSessionPool.hpp"
+#include "connector/trade/NonceGenerator.hpp"
 
 
 
@@ -27,23 +27,21 @@ int test_send() {
     std::string APIKey = config->getString("Kraken.APIKey");
     std::string PrivateKey = config->getString("Kraken.PrivateKey");
 
-    Poco::Net::HTTPSClientSession session("api.kraken.com");
+    HttpsSessionPool::Options options;
+    options.host = "api.kraken.com";
+    options.size = 1;
+    HttpsSessionPool sessions(options);
     std::string content = "pair=XBTUSD&type=buy&ordertype=market&volume=0.1";
-    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, "/0/private/AddOrder");
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, "/0/private/AddOrder", Poco::Net::HTTPMessage::HTTP_1_1);
     request.setContentType("application/x-www-form-urlencoded");
     request.set("API-Key", APIKey);
-    std::string nonce = std::to_string(time(nullptr));
+    NonceGenerator nonces;
+    std::string nonce = std::to_string(nonces.next());
 
     request.set("API-Sign", signMessage(nonce + request.getURI() + content, PrivateKey));
     request.set("nonce", nonce);
-    std::ostream& requestContentStream = session.sendRequest(request);
-    requestContentStream << content;
-
-    Poco::Net::HTTPResponse response;
-    std::istream& responseContentStream = session.receiveResponse(response);
     std::string responseContent;
-
-    Poco::StreamCopier::copyToString(responseContentStream, responseContent);
+    sessions.send(request, content, responseContent);
     std::cout << responseContent << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include <Poco/Exception.h>
+#include <Poco/JSON/Object.h>
+#include <Poco/JSON/Parser.h>
+#include <Poco/Logger.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/WebSocket.h>
+#include "connector/input/WsMessageReader.hpp"
+#include "LatencyTrace.hpp"
+#include "connector/trade/KrakenWsTrading.hpp"
+
+namespace {
+// How long the reader waits for data at a time, bounds how late pings and
+// shutdown happen. The wait is a poll: a receive that times out partway through
+// a frame cannot be resumed.
+const Poco::Timespan poll_interval(1, 0);
+// Sessions that answer no ping for this many intervals are reconnected.
+const int missed_pings_limit = 3;
+const auto reconnect_delay = std::chrono::seconds(1);
+
+std::string order_message(const std::string& token, uint64_t reqid, const std::string& pair, const std::string& type,
+                          const std::string& volume) {
+  return "{\"event\":\"addOrder\",\"token\":\"" + token + "\",\"reqid\":" + std::to_string(reqid)
+         + ",\"ordertype\":\"market\",\"type\":\"" + type + "\",\"pair\":\"" + pair + "\",\"volume\":\"" + volume + "\"}";
+}
+} //namespace
+
+KrakenWsTrading::KrakenWsTrading(Options options, TokenSource token_source) :
+    options(std::move(options)), token_source(std::move(token_source)),
+    logger(Poco::Logger::root().get("KrakenWsTrading")) {
+}
+
+KrakenWsTrading::~KrakenWsTrading() {
+  stopping = true;
+  if (reader.joinable())
+    reader.join();
+  fail_pending("Order entry stopped, order state unknown");
+}
+
+void KrakenWsTrading::start() {
+  reader = std::thread(&KrakenWsTrading::run, this);
+}
+
+bool KrakenWsTrading::connected() const {
+  return is_connected.load(std::memory_order_acquire);
+}
+
+void KrakenWsTrading::connect() {
+  token = token_source();
+  std::unique_ptr<Poco::Net::HTTPClientSession> session;
+  if (!options.secure)
+    session = std::make_unique<Poco::Net::HTTPClientSession>(options.host, options.port);
+  else if (options.context.isNull())
+    session = std::make_unique<Poco::Net::HTTPSClientSession>(options.host, options.port);
+  else
+    session = std::make_unique<Poco::Net::HTTPSClientSession>(options.host, options.port, options.context);
+  Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, options.path, Poco::Net::HTTPMessage::HTTP_1_1);
+  Poco::Net::HTTPResponse response;
+  auto socket = std::make_unique<Poco::Net::WebSocket>(*session, request, response);
+  {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    ws = std::move(socket);
+  }
+  is_connected.store(true, std::memory_order_release);
+  poco_notice(logger, "Connected to " + options.host);
+}
+
+void KrakenWsTrading::run() {
+  while (!stopping) {
+    try {
+      connect();
+      auto last_received = std::chrono::steady_clock::now();
+      auto last_activity = last_received;
+      WsMessageReader messages;
+      while (!stopping) {
+        // available() covers bytes TLS has already decrypted, which the socket does not signal.
+        if (ws->available() == 0 && !ws->poll(poll_interval, Poco::Net::Socket::SELECT_READ)) {
+          const auto now = std::chrono::steady_clock::now();
+          if (now - last_received >= missed_pings_limit * options.ping_interval) {
+            poco_warning(logger, "No response from " + options.host + ", reconnecting");
+            break;
+          }
+          if (now - last_activity >= options.ping_interval) {
+            std::string ping = "{\"event\":\"ping\"}";
+            std::lock_guard<std::mutex> lock(send_mutex);
+            ws->sendFrame(ping.data(), ping.size());
+            last_activity = now;
+          }
+          continue;
+        }
+        if (!messages.receive(*ws))
+          break;
+        last_received = std::chrono::steady_clock::now();
+        last_activity = last_received;
+        if (messages.opcode() == Poco::Net::WebSocket::FRAME_OP_TEXT)
+          handle_message(std::string(messages.data(), messages.size()));
+      }
+      poco_notice(logger, "Disconnected from " + options.host);
+    } catch (Poco::Exception& e) {
+      poco_warning(logger, "Order entry session failed: " + e.displayText());
+    } catch (std::exception& e) {
+      poco_warning(logger, std::string("Order entry session failed: ") + e.what());
+    }
+    is_connected.store(false, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(send_mutex);
+      if (ws) {
+        try {
+          ws->close();
+        } catch (Poco::Exception&) {
+        }
+        ws.reset();
+      }
+    }
+    fail_pending("Order entry session dropped, order state unknown");
+    if (!stopping)
+      std::this_thread::sleep_for(reconnect_delay);
+  }
+}
+
+std::optional<std::future<OrderResult>> KrakenWsTrading::add_order(const std::string& pair, const std::string& type,
+                                                                   const std::string& volume, OrderCallback&& on_done) {
+  uint64_t reqid;
+  std::future<OrderResult> rv;
+  std::string error;
+  {
+    // Checked and sent under one lock, so the session cannot drop in between.
+    std::lock_guard<std::mutex> send_lock(send_mutex);
+    if (!ws || !connected())
+      return std::nullopt;
+    reqid = next_reqid.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex);
+      PendingOrder& order = pending[reqid];
+      order.on_done = std::move(on_done);
+      order.sent_ns = trace_now();
+      rv = order.promise.get_future();
+    }
+    try {
+      std::string message = order_message(token, reqid, pair, type, volume);
+      ws->sendFrame(message.data(), message.size());
+    } catch (Poco::Exception& e) {
+      error = e.displayText();
+    }
+  }
+  // Part of the frame may have gone out, so the order is failed, not resent.
+  if (!error.empty()) {
+    OrderResult failed;
+    failed.errors.push_back("Order not sent: " + error);
+    complete(reqid, std::move(failed));
+  }
+  return rv;
+}
+
+// {"event":"addOrderStatus","reqid":1,"status":"ok","txid":"O...","descr":"..."}
+// {"event":"addOrderStatus","reqid":1,"status":"error","errorMessage":"EOrder:..."}
+void KrakenWsTrading::handle_message(const std::string& message) {
+  if (message.empty() || message[0] != '{')
+    return;
+  try {
+    Poco::JSON::Parser parser;
+    Poco::JSON::Object::Ptr object = parser.parse(message).extract<Poco::JSON::Object::Ptr>();
+    std::string event = object->optValue<std::string>("event", "");
+    if (event == "addOrderStatus") {
+      if (!object->has("reqid")) {
+        poco_warning(logger, "addOrderStatus without reqid: " + message);
+        return;
+      }
+      OrderResult result;
+      if (object->optValue<std::string>("status", "") == "ok") {
+        result.txids.push_back(object->optValue<std::string>("txid", ""));
+        result.ok = !result.txids.front().empty();
+      } else {
+        result.errors.push_back(object->optValue<std::string>("errorMessage", "unknown error"));
+      }
+      complete(object->getValue<uint64_t>("reqid"), std::move(result));
+    } else if (event == "error") {
+      poco_warning(logger, "Order entry error: " + message);
+    }
+  } catch (Poco::Exception& e) {
+    poco_warning(logger, "Cannot handle order entry message " + message + " - error " + e.displayText());
+  }
+}
+
+void KrakenWsTrading::complete(uint64_t reqid, OrderResult result) {
+  PendingOrder order;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    auto it = pending.find(reqid);
+    if (it == pending.end())
+      return;
+    order = std::move(it->second);
+    pending.erase(it);
+  }
+  trace_span(TraceSpan::OrderRoundTrip, order.sent_ns, trace_now());
+  if (!result.ok)
+    poco_error(logger, "Order " + std::to_string(reqid) + " failed" + (result.errors.empty() ? std::string() : ": " + result.errors.front()));
+  finish(reqid, order, std::move(result));
+}
+
+void KrakenWsTrading::fail_pending(const std::string& error) {
+  std::unordered_map<uint64_t, PendingOrder> failed;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    failed.swap(pending);
+  }
+  for (auto& [reqid, order] : failed) {
+    OrderResult result;
+    result.errors.push_back(error);
+    finish(reqid, order, std::move(result));
+  }
+}
+
+// A throwing callback must neither leave the future broken nor unwind the reader.
+void KrakenWsTrading::finish(uint64_t reqid, PendingOrder& order, OrderResult result) {
+  if (order.on_done) {
+    try {
+      order.on_done(result);
+    } catch (std::exception& e) {
+      poco_error(logger, "Callback of order " + std::to_string(reqid) + " failed: " + e.what());
+    } catch (...) {
+      poco_error(logger, "Callback of order " + std::to_string(reqid) + " failed");
+    }
+  }
+  order.promise.set_value(std::move(result));
+}
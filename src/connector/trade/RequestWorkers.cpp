@@ -0,0 +1,30 @@
+#include "connector/trade/RequestWorkers.hpp"
+
+RequestWorkers::RequestWorkers(size_t count) {
+  for (size_t i = 0; i < count; i++)
+    threads.emplace_back(&RequestWorkers::run, this);
+}
+
+RequestWorkers::~RequestWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    stopping = true;
+  }
+  task_added.notify_all();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+void RequestWorkers::run() {
+  std::unique_lock<std::mutex> lock(tasks_mutex);
+  while (true) {
+    task_added.wait(lock, [this] { return stopping || !tasks.empty(); });
+    if (tasks.empty())
+      return;
+    std::function<void()> task = std::move(tasks.front());
+    tasks.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
@@ -0,0 +1,74 @@
+#include <limits>
+#include "strategy/CycleSizeSolver.hpp"
+
+namespace {
+// Remaining capacities below this are treated as a reached breakpoint.
+const double epsilon = 1e-12;
+
+double to_double(Amount amount) {
+  return double(amount.raw()) / double(Amount::one);
+}
+} //namespace
+
+Amount convert_along(std::span<const BookHandle> legs, Amount amount) {
+  for (const BookHandle& leg : legs) {
+    amount = leg.convert(amount - leg.fee(amount));
+    if (amount.is_zero())
+      break;
+  }
+  return amount;
+}
+
+CycleSizeSolver::Result CycleSizeSolver::solve(std::span<const BookHandle> legs) {
+  const size_t n = legs.size();
+  if (curves.size() < n)
+    curves.resize(n);
+  positions.assign(n, 0);
+  remaining.assign(n, 0);
+  fee_keep.assign(n, 1);
+
+  // Capacities are kept in each leg's input units before fees.
+  for (size_t j = 0; j < n; j++) {
+    legs[j].book->get_conversion_curve(legs[j].reversed, curves[j]);
+    if (curves[j].empty())
+      return {};
+    fee_keep[j] = 1 - to_double(legs[j].fee(Amount::from_integer(1)));
+    remaining[j] = to_double(curves[j][0].capacity) / fee_keep[j];
+  }
+
+  double x = 0;
+  bool exhausted = false;
+  while (!exhausted) {
+    // growth: how much leg j's input moves per unit of x, marginal rate of the chain at the end.
+    double growth = 1;
+    double step = std::numeric_limits<double>::infinity();
+    for (size_t j = 0; j < n; j++) {
+      step = std::min(step, remaining[j] / growth);
+      growth *= curves[j][positions[j]].rate * fee_keep[j];
+    }
+    if (growth <= 1)
+      break;
+
+    x += step;
+    growth = 1;
+    for (size_t j = 0; j < n; j++) {
+      remaining[j] -= step * growth;
+      growth *= curves[j][positions[j]].rate * fee_keep[j];
+      if (remaining[j] > epsilon * (1 + to_double(curves[j][positions[j]].capacity)))
+        continue;
+      if (++positions[j] == curves[j].size()) {
+        exhausted = true;
+        break;
+      }
+      remaining[j] = to_double(curves[j][positions[j]].capacity) / fee_keep[j];
+    }
+  }
+
+  Amount amount_in = Amount::from_raw(__int128(x * double(Amount::one)));
+  if (amount_in.is_zero())
+    return {};
+  Amount amount_out = convert_along(legs, amount_in);
+  if (amount_out <= amount_in)
+    return {};
+  return {amount_in, amount_out};
+}
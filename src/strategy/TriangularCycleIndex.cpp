@@ -0,0 +1,152 @@
+#include <algorithm>
+#include "strategy/TriangularCycleIndex.hpp"
+#include "LatencyTrace.hpp"
+
+namespace {
+const TradingGraph::Edge* find_edge(const TradingGraph& graph, uint32_t from, uint32_t to) {
+  std::span<const TradingGraph::Edge> edges = graph.edges_from(from);
+  auto it = std::lower_bound(edges.begin(), edges.end(), to, [](const TradingGraph::Edge& e, uint32_t target) {
+    return e.target < target;
+  });
+  return it != edges.end() && it->target == to ? &*it : nullptr;
+}
+
+// Times the newest book update of the cycle to this detection and leaves its
+// receive time as the trigger of the orders the callback sends, until the
+// guard goes out of scope: orders sent later are not this frame's.
+class DetectionTrace {
+public:
+  explicit DetectionTrace(const TriangularCycleIndex::Cycle& cycle) {
+    if constexpr (latency_trace_enabled) {
+      uint64_t received = 0, updated = 0;
+      for (const BookHandle& leg : cycle.legs) {
+        received = std::max(received, leg.book->get_trace_received_ns());
+        updated = std::max(updated, leg.book->get_trace_updated_ns());
+      }
+      const uint64_t detected = trace_now();
+      trace_span(TraceSpan::Detect, updated, detected);
+      trace_span(TraceSpan::TickToDetect, received, detected);
+      trace_trigger_ns = received;
+    }
+  }
+  ~DetectionTrace() {
+    if constexpr (latency_trace_enabled)
+      trace_trigger_ns = 0;
+  }
+  DetectionTrace(const DetectionTrace&) = delete;
+};
+} //namespace
+
+TriangularCycleIndex::TriangularCycleIndex(const TradingGraph& graph) : graph(graph) {
+  cycles_by_start.assign(graph.node_count() + 1, 0);
+  for (uint32_t start = 0; start < graph.node_count(); start++) {
+    for (const TradingGraph::Edge& first : graph.edges_from(start)) {
+      for (const TradingGraph::Edge& second : graph.edges_from(first.target)) {
+        if (second.target == start)
+          continue;
+        const TradingGraph::Edge* third = find_edge(graph, second.target, start);
+        if (third != nullptr)
+          cycles.push_back({start, {first.handle, second.handle, third->handle}});
+      }
+    }
+    cycles_by_start[start + 1] = cycles.size();
+  }
+
+  for (const Cycle& cycle : cycles) {
+    for (const BookHandle& leg : cycle.legs)
+      books.push_back(leg.book);
+  }
+  std::sort(books.begin(), books.end());
+  books.erase(std::unique(books.begin(), books.end()), books.end());
+
+  auto book_position = [this](const LeveledOrderBook* book) {
+    return std::lower_bound(books.begin(), books.end(), book) - books.begin();
+  };
+  book_cycle_offsets.assign(books.size() + 1, 0);
+  for (const Cycle& cycle : cycles) {
+    for (const BookHandle& leg : cycle.legs)
+      book_cycle_offsets[book_position(leg.book) + 1]++;
+  }
+  for (size_t i = 0; i < books.size(); i++)
+    book_cycle_offsets[i + 1] += book_cycle_offsets[i];
+
+  book_cycles.resize(book_cycle_offsets.back());
+  std::vector<uint32_t> fill(book_cycle_offsets.begin(), book_cycle_offsets.end() - 1);
+  for (uint32_t c = 0; c < cycles.size(); c++) {
+    for (const BookHandle& leg : cycles[c].legs)
+      book_cycles[fill[book_position(leg.book)]++] = c;
+  }
+
+  cycle_stamps.assign(cycles.size(), 0);
+}
+
+std::span<const TriangularCycleIndex::Cycle> TriangularCycleIndex::cycles_from(uint32_t start) const {
+  return std::span<const Cycle>(cycles.data() + cycles_by_start[start], cycles_by_start[start + 1] - cycles_by_start[start]);
+}
+
+size_t TriangularCycleIndex::evaluate(const Cycle& cycle, Amount base_amount, const Callback& callback) const {
+  Amount amount_in = base_amount.mul(graph.symbol(cycle.start).get_reference_rate_estimate());
+  if (amount_in.is_zero())
+    return 0;
+
+  Amount amount = convert_along(cycle.legs, amount_in);
+  if (amount <= amount_in)
+    return 0;
+
+  const DetectionTrace trace(cycle);
+  callback(cycle, amount_in, amount);
+  return 1;
+}
+
+void TriangularCycleIndex::collect(std::span<const GenericOrderBook* const> changed) {
+  if (++stamp == 0) {
+    std::fill(cycle_stamps.begin(), cycle_stamps.end(), 0);
+    stamp = 1;
+  }
+
+  pending.clear();
+  for (const GenericOrderBook* book : changed) {
+    auto it = std::lower_bound(books.begin(), books.end(), book, [](const LeveledOrderBook* a, const GenericOrderBook* b) {
+      return static_cast<const GenericOrderBook*>(a) < b;
+    });
+    if (it == books.end() || *it != book)
+      continue;
+    size_t position = it - books.begin();
+    for (uint32_t i = book_cycle_offsets[position]; i < book_cycle_offsets[position + 1]; i++) {
+      uint32_t c = book_cycles[i];
+      if (cycle_stamps[c] != stamp) {
+        cycle_stamps[c] = stamp;
+        pending.push_back(c);
+      }
+    }
+  }
+}
+
+size_t TriangularCycleIndex::reprice(std::span<const GenericOrderBook* const> changed, Amount base_amount, const Callback& callback) {
+  collect(changed);
+  size_t found = 0;
+  for (uint32_t c : pending)
+    found += evaluate(cycles[c], base_amount, callback);
+  return found;
+}
+
+size_t TriangularCycleIndex::reprice_all(Amount base_amount, const Callback& callback) {
+  size_t found = 0;
+  for (const Cycle& cycle : cycles)
+    found += evaluate(cycle, base_amount, callback);
+  return found;
+}
+
+size_t TriangularCycleIndex::reprice_optimal(std::span<const GenericOrderBook* const> changed, const Callback& callback) {
+  collect(changed);
+  size_t found = 0;
+  for (uint32_t c : pending) {
+    CycleSizeSolver::Result result = solver.solve(cycles[c].legs);
+    if (result.amount_in.is_zero())
+      continue;
+    const DetectionTrace trace(cycles[c]);
+    callback(cycles[c], result.amount_in, result.amount_out);
+    found++;
+  }
+  return found;
+}